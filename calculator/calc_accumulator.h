@@ -0,0 +1,245 @@
+#pragma once
+
+
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "calc_numbers.h"
+#include "calc_arithmetic.h"
+#include "calc_storage.h"
+
+
+
+namespace calc {
+
+
+
+    /*      A digit of a base with b symbols never exceeds b - 1, yet every digit field of digit_block_data holds up to 255; a decimal field
+    /*  has room for 28 digits' worth of sum. An accumulator adds terms field by field as plain 64 bit additions of whole words and leaves
+    /*  the carries where they are. It tracks the largest value any field may have reached, and only when the next term could push a field
+    /*  past 255 are the carries propagated. Reading, printing or comparing the sum normalizes it.
+    /*
+    /*      Negative terms are collected in a second bank so that fields never borrow; the banks are subtracted once when the sum is read.
+    /*  Bases above 128 symbols have no headroom left and fall back to adding with carries.
+    */
+    struct accumulator {
+
+        using word_vector = std::vector<std::uint64_t, spill_allocator<std::uint64_t>>;
+
+        /*  words:  Digit fields in the layout of digit_block_data, least significant word first.
+        /*  bound:  The largest value any field may hold.
+        */
+        struct bank {
+            word_vector words{};
+            std::uint64_t bound{};
+        };
+
+        number_base* base{};
+        radix rad{};
+
+        bank positive{};
+        bank negative{};
+
+        /* field value + carry never exceeds 511; these split it into the next carry and the field's digit */
+        std::array<std::uint8_t, 512> carry_of{};
+        std::array<std::uint8_t, 512> digit_of{};
+
+
+        explicit accumulator(number_base* base)
+            : base(base), rad(make_radix(std::strlen(base->symbol_vec)))
+        {
+            for (std::uint64_t value{}; value < carry_of.size(); value++) {
+                carry_of[value] = static_cast<std::uint8_t>(value / rad.symbols);
+                digit_of[value] = static_cast<std::uint8_t>(value % rad.symbols);
+            }
+        }
+
+
+
+        /* propagates every carry of a bank, afterwards each field holds a single digit */
+        void normalize(bank& target) {
+            if (target.bound < rad.symbols)
+                return;
+
+            std::uint64_t carry{};
+
+            for (std::uint64_t& word : target.words) {
+                std::uint64_t fields{};
+
+                for (std::uint64_t shift{}; shift < DIGITS_PER_BLOCK * BITS_PER_DIGIT; shift += BITS_PER_DIGIT) {
+                    std::uint64_t value{ ((word >> shift) & 0xff) + carry };
+
+                    carry = carry_of[value];
+                    fields |= std::uint64_t{ digit_of[value] } << shift;
+                }
+
+                word = fields;
+            }
+
+            while (carry) {
+                std::uint64_t fields{};
+
+                for (std::uint64_t shift{}; shift < DIGITS_PER_BLOCK * BITS_PER_DIGIT && carry; shift += BITS_PER_DIGIT) {
+                    fields |= std::uint64_t{ digit_of[carry] } << shift;
+                    carry = carry_of[carry];
+                }
+
+                target.words.push_back(fields);
+            }
+
+            target.bound = rad.symbols - 1;
+            detail::checkpoint(target.words.size());
+        }
+
+        /* adds a term of count words to a bank; emit hands every word of the term, in order, to the visitor it is given */
+        template<typename Emit>
+        void accumulate(bank& target, std::uint64_t count, Emit&& emit) {
+            const std::uint64_t top{ rad.symbols - 1 };
+
+            if (top + top <= 0xff) {
+                if (target.bound + top > 0xff)
+                    normalize(target);
+
+                if (target.words.size() < count)
+                    target.words.resize(count);
+
+                emit([&target](std::uint64_t ind, std::uint64_t fields) {
+                    target.words[ind] += fields;
+                });
+
+                target.bound += top;
+            }
+            else {
+                normalize(target);
+
+                if (target.words.size() < count)
+                    target.words.resize(count);
+
+                std::uint64_t carry{};
+
+                auto add_word{ [this, &target, &carry](std::uint64_t ind, std::uint64_t term) {
+                    std::uint64_t word{ target.words[ind] };
+                    std::uint64_t fields{};
+
+                    for (std::uint64_t shift{}; shift < DIGITS_PER_BLOCK * BITS_PER_DIGIT; shift += BITS_PER_DIGIT) {
+                        std::uint64_t value{ ((word >> shift) & 0xff) + ((term >> shift) & 0xff) + carry };
+
+                        carry = carry_of[value];
+                        fields |= std::uint64_t{ digit_of[value] } << shift;
+                    }
+
+                    target.words[ind] = fields;
+                } };
+
+                emit(add_word);
+
+                for (std::uint64_t ind{ count }; carry; ind++) {
+                    if (ind == target.words.size())
+                        target.words.push_back(0);
+
+                    add_word(ind, 0);
+                }
+
+                target.bound = top;
+            }
+
+            detail::checkpoint(count);
+        }
+
+
+
+        void add(const number& term) {
+            collect(term, false);
+        }
+        void subtract(const number& term) {
+            collect(term, true);
+        }
+        void add(const integer& term) {
+            collect(term, false);
+        }
+        void subtract(const integer& term) {
+            collect(term, true);
+        }
+        void clear() {
+            positive = bank{};
+            negative = bank{};
+        }
+
+
+
+        /* the normalized sum */
+        integer value() {
+            normalize(positive);
+            normalize(negative);
+
+            auto sum_of{ [this](const bank& source) {
+                return integer{ detail::unpack_digits([&source](std::uint64_t ind) { return source.words[ind]; }, source.words.size(), rad), false, rad };
+            } };
+
+            return calc::subtract(sum_of(positive), sum_of(negative));
+        }
+        void store(number& num) {
+            calc::store(num, value());
+        }
+        /* -1, 0 or 1 as the sum is below, equal to or above rhs */
+        int compare(const number& rhs) {
+            integer lhs{ value() };
+            integer other{ rebase(load(rhs), rad) };
+
+            if (lhs.negative != other.negative)
+                return lhs.negative ? -1 : 1;
+
+            int order{ detail::compare(lhs.magnitude, other.magnitude) };
+
+            return lhs.negative ? -order : order;
+        }
+
+        friend std::wostream& operator<<(std::wostream& lhs, accumulator& rhs) {
+            number sum{ rhs.base };
+            rhs.store(sum);
+
+            return lhs << sum;
+        }
+
+
+
+        void collect(const number& term, bool subtracting) {
+            if (term.block == nullptr)
+                return;
+
+            bank& target{ term.negative.load() != subtracting ? negative : positive };
+
+            /* digits index the same symbol count the same way, so the fields can be added as they are */
+            if (term.base_size() == rad.symbols) {
+                accumulate(target, term.size, [&term](auto&& visit) {
+                    for (std::uint64_t ind{}; ind < term.size; ind++)
+                        visit(ind, *reinterpret_cast<const std::uint64_t*>(term.block[ind].data));
+                });
+
+                return;
+            }
+
+            collect(rebase(load(term), rad), subtracting);
+        }
+        void collect(const integer& term, bool subtracting) {
+            if (term.is_zero())
+                return;
+
+            integer x{ rebase(term, rad) };
+            bank& target{ x.negative != subtracting ? negative : positive };
+
+            std::uint64_t digit_count{ detail::digit_count(x) };
+
+            accumulate(target, (digit_count + DIGITS_PER_BLOCK - 1) / DIGITS_PER_BLOCK, [&x, digit_count](auto&& visit) {
+                detail::pack_digits(x, digit_count, visit);
+            });
+        }
+    };
+
+
+
+} /* end calc */
@@ -0,0 +1,1042 @@
+#pragma once
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "calc_numbers.h"
+#include "calc_storage.h"
+
+
+
+namespace calc {
+
+
+
+    /*      Arithmetic does not run on the digit_block chain directly. A number is loaded into a little-endian vector of limbs where each limb
+    /*  packs as many digits of the number's base as fit below 2^32, e.g. nine decimal digits or thirty-two binary digits. The product of two
+    /*  limbs plus two carries then always fits a std::uint64_t, which keeps every kernel free of compiler specific wide integers.
+    /*
+    /*      Limb storage is charged to the memory budget and spills to temporary files past it, see calc_storage.h.
+    */
+    using limb = std::uint32_t;
+    using limb_vector = std::vector<limb, spill_allocator<limb>>;
+
+    constexpr std::size_t KARATSUBA_THRESHOLD = 32;    /* limbs; below this schoolbook multiplication is faster */
+    constexpr std::size_t BLOCKED_MIN_SLICE = 1 << 16;  /* limbs; out of core slices are never shorter than this   */
+    constexpr std::size_t DIVIDE_RECURSIVE_THRESHOLD = 64; /* limbs; shorter divisors and quotients use long division */
+    constexpr std::uint64_t CHECKPOINT_GRANULE = 1 << 16; /* limb operations between cancellation checks              */
+
+
+
+    /*  symbols:         The number of unique numerals of the base.
+    /*  digits_per_limb: How many digits are packed into one limb.
+    /*  limb_base:       symbols ^ digits_per_limb, the radix the kernels work in.
+    */
+    struct radix {
+        std::uint64_t symbols{};
+        std::uint64_t digits_per_limb{};
+        std::uint64_t limb_base{};
+
+        /* bases 2, 4, 16 and 256 share a limb base but not their digits, so both have to match */
+        friend bool operator==(const radix& lhs, const radix& rhs) {
+            return lhs.limb_base == rhs.limb_base && lhs.symbols == rhs.symbols;
+        }
+    };
+    inline radix make_radix(std::uint64_t symbols) {
+        if (symbols < 2 || symbols > (1 << BITS_PER_DIGIT))
+            throw std::invalid_argument{ "Base must have between 2 and 256 symbols" };
+
+        radix rad{ symbols, 0, 1 };
+
+        while (rad.limb_base * symbols <= (std::uint64_t{ 1 } << 32)) {
+            rad.limb_base *= symbols;
+            rad.digits_per_limb++;
+        }
+
+        return rad;
+    }
+
+
+
+    /*  integer: A signed magnitude in the limbs of some radix. The magnitude never holds leading zero limbs; zero is the empty vector. */
+    struct integer {
+        limb_vector magnitude{};
+        bool negative{};
+        radix rad{};
+
+        bool is_zero() const {
+            return magnitude.empty();
+        }
+    };
+
+
+
+    struct evaluation_cancelled : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+
+
+    /*      Shared between whoever waits on an evaluation and the thread running it. Kernels report the limb operations they complete and
+    /*  poll for cancellation between chunks of work; a cancelled or expired evaluation unwinds by throwing evaluation_cancelled from the
+    /*  next checkpoint. stages_completed counts the operations of the problem which have been applied out of stages_total.
+    */
+    struct evaluation_control {
+        std::atomic<bool> cancel_requested{};
+        std::chrono::steady_clock::time_point deadline{ std::chrono::steady_clock::time_point::max() };
+
+        std::atomic<std::uint64_t> stages_total{};
+        std::atomic<std::uint64_t> stages_completed{};
+        std::atomic<std::uint64_t> work_completed{};
+
+        void cancel() {
+            cancel_requested.store(true);
+        }
+        bool expired() const {
+            if (cancel_requested.load(std::memory_order_relaxed))
+                return true;
+
+            return deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline;
+        }
+    };
+
+
+
+    namespace detail {
+
+
+
+        inline thread_local evaluation_control* active_control{};
+        inline thread_local std::uint64_t pending_work{};
+
+        /* flushes pending work to the active control and throws if the evaluation should stop */
+        inline void poll_control() {
+            if (active_control == nullptr)
+                return;
+
+            active_control->work_completed.fetch_add(pending_work, std::memory_order_relaxed);
+            pending_work = 0;
+
+            if (active_control->expired())
+                throw evaluation_cancelled{ "Evaluation cancelled" };
+        }
+        /* called by kernels after finishing a chunk of work; only every CHECKPOINT_GRANULE operations reach the shared control */
+        inline void checkpoint(std::uint64_t work) {
+            if (active_control == nullptr)
+                return;
+
+            pending_work += work;
+
+            if (pending_work >= CHECKPOINT_GRANULE)
+                poll_control();
+        }
+
+        /* installs a control block as the calling thread's active control for the lifetime of the scope */
+        struct control_scope {
+            evaluation_control* previous{};
+
+            control_scope(evaluation_control* control)
+                : previous(active_control)
+            {
+                active_control = control;
+                pending_work = 0;
+            }
+            ~control_scope() {
+                if (active_control)
+                    active_control->work_completed.fetch_add(pending_work, std::memory_order_relaxed);
+
+                active_control = previous;
+                pending_work = 0;
+            }
+        };
+
+
+
+        inline void trim(limb_vector& x) {
+            while (!x.empty() && x.back() == 0)
+                x.pop_back();
+        }
+
+
+
+        inline int compare(const limb* a, std::size_t an, const limb* b, std::size_t bn) {
+            if (an != bn)
+                return an < bn ? -1 : 1;
+
+            for (std::size_t ind{ an }; ind-- > 0;) {
+                if (a[ind] != b[ind])
+                    return a[ind] < b[ind] ? -1 : 1;
+            }
+
+            return 0;
+        }
+        inline int compare(const limb_vector& a, const limb_vector& b) {
+            return compare(a.data(), a.size(), b.data(), b.size());
+        }
+
+
+
+        /* r += x * limb_base^shift */
+        inline void add_shifted(limb_vector& r, const limb* x, std::size_t xn, std::size_t shift, std::uint64_t limb_base) {
+            if (r.size() < shift + xn)
+                r.resize(shift + xn);
+
+            std::uint64_t carry{};
+
+            for (std::size_t ind{}; ind < xn; ind++) {
+                std::uint64_t sum{ std::uint64_t{ r[shift + ind] } + x[ind] + carry };
+                carry = sum >= limb_base;
+                r[shift + ind] = static_cast<limb>(carry ? sum - limb_base : sum);
+            }
+
+            for (std::size_t ind{ shift + xn }; carry; ind++) {
+                if (ind == r.size())
+                    r.push_back(0);
+
+                std::uint64_t sum{ std::uint64_t{ r[ind] } + carry };
+                carry = sum >= limb_base;
+                r[ind] = static_cast<limb>(carry ? sum - limb_base : sum);
+            }
+        }
+        /* r -= x * limb_base^shift, the caller guarantees the result is not negative */
+        inline void sub_shifted(limb_vector& r, const limb* x, std::size_t xn, std::size_t shift, std::uint64_t limb_base) {
+            std::uint64_t borrow{};
+
+            for (std::size_t ind{}; ind < xn; ind++) {
+                std::uint64_t take{ std::uint64_t{ x[ind] } + borrow };
+                borrow = r[shift + ind] < take;
+                r[shift + ind] = static_cast<limb>(r[shift + ind] + (borrow ? limb_base : 0) - take);
+            }
+
+            for (std::size_t ind{ shift + xn }; borrow; ind++) {
+                borrow = r[ind] == 0;
+                r[ind] = static_cast<limb>(borrow ? limb_base - 1 : r[ind] - 1);
+            }
+
+            trim(r);
+        }
+        inline limb_vector add(const limb* a, std::size_t an, const limb* b, std::size_t bn, std::uint64_t limb_base) {
+            limb_vector r(a, a + an);
+            add_shifted(r, b, bn, 0, limb_base);
+            trim(r);
+            return r;
+        }
+
+
+
+        /* r = r * m + add, where m <= 2^32 */
+        inline void mul_1(limb_vector& r, std::uint64_t m, std::uint64_t add, std::uint64_t limb_base) {
+            std::uint64_t carry{ add };
+
+            for (limb& x : r) {
+                std::uint64_t product{ x * m + carry };
+                x = static_cast<limb>(product % limb_base);
+                carry = product / limb_base;
+            }
+
+            while (carry) {
+                r.push_back(static_cast<limb>(carry % limb_base));
+                carry /= limb_base;
+            }
+
+            trim(r);
+        }
+        /* q = q / d, returns the remainder */
+        inline std::uint64_t divmod_1(limb_vector& q, std::uint64_t d, std::uint64_t limb_base) {
+            std::uint64_t rem{};
+
+            for (std::size_t ind{ q.size() }; ind-- > 0;) {
+                std::uint64_t cur{ rem * limb_base + q[ind] };
+                q[ind] = static_cast<limb>(cur / d);
+                rem = cur % d;
+            }
+
+            trim(q);
+            return rem;
+        }
+
+
+
+        inline limb_vector mul_schoolbook(const limb* a, std::size_t an, const limb* b, std::size_t bn, std::uint64_t limb_base) {
+            limb_vector r(an + bn);
+
+            for (std::size_t i{}; i < an; i++) {
+                if (a[i] == 0)
+                    continue;
+
+                std::uint64_t carry{};
+
+                for (std::size_t j{}; j < bn; j++) {
+                    std::uint64_t t{ std::uint64_t{ a[i] } * b[j] + r[i + j] + carry };
+                    r[i + j] = static_cast<limb>(t % limb_base);
+                    carry = t / limb_base;
+                }
+
+                r[i + bn] = static_cast<limb>(carry);
+
+                checkpoint(bn);
+            }
+
+            trim(r);
+            return r;
+        }
+
+
+
+        /*      Squaring needs each cross product a[i] * a[j], i < j, only once. They are summed, doubled and the diagonal a[i]^2 is added last,
+        /*  which is about half the limb products of a general schoolbook multiply.
+        */
+        inline limb_vector sqr_schoolbook(const limb* a, std::size_t n, std::uint64_t limb_base) {
+            limb_vector r(2 * n);
+
+            for (std::size_t i{}; i < n; i++) {
+                if (a[i] == 0)
+                    continue;
+
+                std::uint64_t carry{};
+
+                for (std::size_t j{ i + 1 }; j < n; j++) {
+                    std::uint64_t t{ std::uint64_t{ a[i] } * a[j] + r[i + j] + carry };
+                    r[i + j] = static_cast<limb>(t % limb_base);
+                    carry = t / limb_base;
+                }
+
+                r[i + n] = static_cast<limb>(carry);
+
+                checkpoint(n - i);
+            }
+
+            /* double the cross products */
+            std::uint64_t carry{};
+
+            for (limb& x : r) {
+                std::uint64_t t{ 2 * std::uint64_t{ x } + carry };
+                x = static_cast<limb>(t % limb_base);
+                carry = t / limb_base;
+            }
+
+            /* add the diagonal */
+            carry = 0;
+
+            for (std::size_t i{}; i < n; i++) {
+                std::uint64_t t{ std::uint64_t{ a[i] } * a[i] };
+
+                std::uint64_t low{ std::uint64_t{ r[2 * i] } + t % limb_base + carry };
+                r[2 * i] = static_cast<limb>(low % limb_base);
+
+                std::uint64_t high{ std::uint64_t{ r[2 * i + 1] } + t / limb_base + low / limb_base };
+                r[2 * i + 1] = static_cast<limb>(high % limb_base);
+                carry = high / limb_base;
+            }
+
+            trim(r);
+            return r;
+        }
+        inline limb_vector square(const limb* a, std::size_t n, std::uint64_t limb_base) {
+            while (n && a[n - 1] == 0) n--;
+
+            if (n == 0)
+                return {};
+
+            if (n < KARATSUBA_THRESHOLD)
+                return sqr_schoolbook(a, n, limb_base);
+
+            /* (a1 * B^m + a0)^2 = a1^2 * B^2m + ((a0 + a1)^2 - a0^2 - a1^2) * B^m + a0^2 */
+            std::size_t m{ n / 2 };
+
+            limb_vector z0{ square(a, m, limb_base) };
+            limb_vector z2{ square(a + m, n - m, limb_base) };
+
+            limb_vector sa{ add(a, m, a + m, n - m, limb_base) };
+            limb_vector z1{ square(sa.data(), sa.size(), limb_base) };
+
+            sub_shifted(z1, z0.data(), z0.size(), 0, limb_base);
+            sub_shifted(z1, z2.data(), z2.size(), 0, limb_base);
+
+            limb_vector r{ std::move(z0) };
+            add_shifted(r, z1.data(), z1.size(), m, limb_base);
+            add_shifted(r, z2.data(), z2.size(), 2 * m, limb_base);
+
+            trim(r);
+            return r;
+        }
+
+
+
+        /*      Karatsuba splits both operands at m limbs, a = a1 * B^m + a0 and b = b1 * B^m + b0, and forms the product from three half size
+        /*  products: z0 = a0 * b0, z2 = a1 * b1 and z1 = (a0 + a1) * (b0 + b1) - z0 - z2. Operands of very different lengths are cut into
+        /*  slices of the shorter length first so that every recursive call is roughly balanced.
+        */
+        inline limb_vector multiply(const limb* a, std::size_t an, const limb* b, std::size_t bn, std::uint64_t limb_base) {
+            while (an && a[an - 1] == 0) an--;
+            while (bn && b[bn - 1] == 0) bn--;
+
+            if (an < bn) {
+                std::swap(a, b);
+                std::swap(an, bn);
+            }
+
+            if (bn == 0)
+                return {};
+
+            /* a single limb operand only needs one linear pass */
+            if (bn == 1) {
+                limb_vector r(a, a + an);
+                mul_1(r, b[0], 0, limb_base);
+                checkpoint(an);
+                return r;
+            }
+
+            if (a == b && an == bn)
+                return square(a, an, limb_base);
+
+            if (bn < KARATSUBA_THRESHOLD)
+                return mul_schoolbook(a, an, b, bn, limb_base);
+
+            if (2 * bn <= an) {
+                limb_vector r{};
+
+                for (std::size_t offset{}; offset < an; offset += bn) {
+                    limb_vector part{ multiply(a + offset, std::min(bn, an - offset), b, bn, limb_base) };
+                    add_shifted(r, part.data(), part.size(), offset, limb_base);
+                }
+
+                trim(r);
+                return r;
+            }
+
+            std::size_t m{ an / 2 };
+
+            limb_vector z0{ multiply(a, m, b, m, limb_base) };
+            limb_vector z2{ multiply(a + m, an - m, b + m, bn - m, limb_base) };
+
+            limb_vector sa{ add(a, m, a + m, an - m, limb_base) };
+            limb_vector sb{ add(b, m, b + m, bn - m, limb_base) };
+            limb_vector z1{ multiply(sa.data(), sa.size(), sb.data(), sb.size(), limb_base) };
+
+            sub_shifted(z1, z0.data(), z0.size(), 0, limb_base);
+            sub_shifted(z1, z2.data(), z2.size(), 0, limb_base);
+
+            limb_vector r{ std::move(z0) };
+            add_shifted(r, z1.data(), z1.size(), m, limb_base);
+            add_shifted(r, z2.data(), z2.size(), 2 * m, limb_base);
+
+            trim(r);
+            return r;
+        }
+
+        /*      Out of core multiplication. When the memory budget can not hold the temporaries of the recursion, about four times the size of
+        /*  the operands, the product is formed from slices of both operands sized from the budget's limit. The partial products
+        /*  are accumulated from the least significant end, so the operands and the result, which may well sit in spill files, are only ever
+        /*  swept in order.
+        */
+        inline limb_vector multiply_blocked(const limb* a, std::size_t an, const limb* b, std::size_t bn, std::uint64_t limb_base, std::size_t slice) {
+            limb_vector r{};
+            r.reserve(an + bn);
+
+            for (std::size_t a_offset{}; a_offset < an; a_offset += slice) {
+                for (std::size_t b_offset{}; b_offset < bn; b_offset += slice) {
+                    limb_vector part{ multiply(a + a_offset, std::min(slice, an - a_offset), b + b_offset, std::min(slice, bn - b_offset), limb_base) };
+                    add_shifted(r, part.data(), part.size(), a_offset + b_offset, limb_base);
+                }
+            }
+
+            trim(r);
+            return r;
+        }
+        inline limb_vector multiply(const limb_vector& a, const limb_vector& b, std::uint64_t limb_base) {
+            if (memory_budget.limited()) {
+                std::uint64_t working{ 4 * (a.size() + b.size()) * sizeof(limb) };
+                std::uint64_t available{ memory_budget.available() };
+
+                /*      The operands are charged to the budget themselves, so once they are out of core nothing is available; slices are sized
+                /*  from the configured limit instead, and kept long enough for Karatsuba to pay off. They are then evened out over the longer
+                /*  operand so that the last one is not a short remainder.
+                */
+                if (working > available) {
+                    std::size_t longest{ std::max(a.size(), b.size()) };
+                    std::size_t slice{ std::max<std::size_t>(static_cast<std::size_t>(memory_budget.limit.load(std::memory_order_relaxed) / (16 * sizeof(limb))), BLOCKED_MIN_SLICE) };
+
+                    if (slice < longest) {
+                        std::size_t slices{ (longest + slice - 1) / slice };
+                        return multiply_blocked(a.data(), a.size(), b.data(), b.size(), limb_base, (longest + slices - 1) / slices);
+                    }
+                }
+            }
+
+            return multiply(a.data(), a.size(), b.data(), b.size(), limb_base);
+        }
+
+
+
+        /*      Long division after Knuth, TAOCP vol. 2, 4.3.1 algorithm D. Both operands are scaled by d = B / (v_top + 1) so the divisor's
+        /*  leading limb is at least B / 2, after which each estimated quotient limb is at most two too large. Every intermediate value stays
+        /*  below B^2 <= 2^64.
+        */
+        inline void divmod_schoolbook(const limb_vector& u, const limb_vector& v, std::uint64_t limb_base, limb_vector& q, limb_vector& r) {
+            if (v.empty())
+                throw std::domain_error{ "Division by zero" };
+
+            if (compare(u, v) < 0) {
+                q.clear();
+                r = u;
+                return;
+            }
+
+            if (v.size() == 1) {
+                q = u;
+                std::uint64_t rem{ divmod_1(q, v[0], limb_base) };
+                r.clear();
+                if (rem) r.push_back(static_cast<limb>(rem));
+                return;
+            }
+
+            std::uint64_t d{ limb_base / (std::uint64_t{ v.back() } + 1) };
+            std::size_t n{ v.size() };
+            std::size_t m{ u.size() - n };
+
+            limb_vector un{ u };
+            limb_vector vn{ v };
+            mul_1(un, d, 0, limb_base);
+            mul_1(vn, d, 0, limb_base);
+            un.resize(u.size() + 1);
+
+            q.assign(m + 1, 0);
+
+            std::uint64_t v_top{ vn[n - 1] };
+            std::uint64_t v_next{ vn[n - 2] };
+
+            for (std::size_t j{ m + 1 }; j-- > 0;) {
+                std::uint64_t num{ un[j + n] * limb_base + un[j + n - 1] };
+                std::uint64_t qhat{ num / v_top };
+                std::uint64_t rhat{ num % v_top };
+
+                while (qhat >= limb_base || qhat * v_next > rhat * limb_base + un[j + n - 2]) {
+                    qhat--;
+                    rhat += v_top;
+                    if (rhat >= limb_base) break;
+                }
+
+                /* multiply and subtract */
+                std::uint64_t carry{};
+                std::uint64_t borrow{};
+
+                for (std::size_t ind{}; ind < n; ind++) {
+                    std::uint64_t product{ qhat * vn[ind] + carry };
+                    carry = product / limb_base;
+
+                    std::uint64_t take{ product % limb_base + borrow };
+                    borrow = un[ind + j] < take;
+                    un[ind + j] = static_cast<limb>(un[ind + j] + (borrow ? limb_base : 0) - take);
+                }
+
+                std::uint64_t take{ carry + borrow };
+                borrow = un[j + n] < take;
+                un[j + n] = static_cast<limb>(un[j + n] + (borrow ? limb_base : 0) - take);
+
+                /* the estimate was one too large, add the divisor back */
+                if (borrow) {
+                    qhat--;
+                    carry = 0;
+
+                    for (std::size_t ind{}; ind < n; ind++) {
+                        std::uint64_t sum{ std::uint64_t{ un[ind + j] } + vn[ind] + carry };
+                        carry = sum >= limb_base;
+                        un[ind + j] = static_cast<limb>(carry ? sum - limb_base : sum);
+                    }
+
+                    un[j + n] = static_cast<limb>((un[j + n] + carry) % limb_base);
+                }
+
+                q[j] = static_cast<limb>(qhat);
+
+                checkpoint(n);
+            }
+
+            trim(q);
+
+            un.resize(n);
+            trim(un);
+            divmod_1(un, d, limb_base);
+            r = std::move(un);
+        }
+
+        /*      Recursive division after Burnikel and Ziegler, in the form of Brent and Zimmermann, Modern Computer Arithmetic, algorithm 1.8.
+        /*  The divisor b of n limbs is normalized, its leading limb at least B / 2, and the quotient has m <= n limbs. The high half of the
+        /*  quotient is the quotient of the high limbs of a by the high n - k limbs of b, which is at most two too large once the neglected low
+        /*  limbs of b are subtracted; the low half follows the same way from the remainder. Both halves are divisions of half the size plus a
+        /*  multiplication, so division costs a small multiple of a multiplication of the same size.
+        */
+        inline void divmod_recursive(const limb_vector& a, const limb_vector& b, std::uint64_t limb_base, limb_vector& q, limb_vector& r) {
+            std::size_t n{ b.size() };
+            std::size_t m{ a.size() > n ? a.size() - n : 0 };
+
+            if (m < DIVIDE_RECURSIVE_THRESHOLD) {
+                divmod_schoolbook(a, b, limb_base, q, r);
+                return;
+            }
+
+            /*      Only the leading m + 1 limbs of b bear on a quotient of m limbs. Dividing by them alone overestimates the quotient, by no
+            /*  more than two since b is normalized, and one multiplication by all of b finds the remainder.
+            */
+            if (n > m + 1) {
+                std::size_t cut{ n - m - 1 };
+                limb_vector unused{};
+
+                divmod_recursive(limb_vector(a.begin() + cut, a.end()), limb_vector(b.begin() + cut, b.end()), limb_base, q, unused);
+
+                limb_vector p{ multiply(q, b, limb_base) };
+                limb_vector x{ a };
+                trim(x);
+
+                while (compare(x, p) < 0) {
+                    add_shifted(x, b.data(), b.size(), 0, limb_base);
+
+                    const limb one{ 1 };
+                    sub_shifted(q, &one, 1, 0, limb_base);
+                }
+
+                sub_shifted(x, p.data(), p.size(), 0, limb_base);
+                r = std::move(x);
+                return;
+            }
+
+            std::size_t k{ m / 2 };
+            const limb_vector b1(b.begin() + k, b.end());
+            limb_vector b0(b.begin(), b.begin() + k);
+            trim(b0);
+
+            /* x = r' * B^shift + the low shift limbs of x, less q' * b0 * B^(shift - k); q' is corrected until that is not negative */
+            auto fold{ [&](limb_vector& x, limb_vector& q_half, const limb_vector& r_half, std::size_t shift) {
+                x.resize(shift);
+                add_shifted(x, r_half.data(), r_half.size(), shift, limb_base);
+                trim(x);
+
+                limb_vector p{ multiply(q_half, b0, limb_base) };
+                p.insert(p.begin(), shift - k, 0);
+                trim(p);
+
+                while (compare(x, p) < 0) {
+                    add_shifted(x, b.data(), b.size(), shift - k, limb_base);
+
+                    const limb one{ 1 };
+                    sub_shifted(q_half, &one, 1, 0, limb_base);
+                }
+
+                sub_shifted(x, p.data(), p.size(), 0, limb_base);
+            } };
+
+            limb_vector q1{};
+            limb_vector r1{};
+            divmod_recursive(limb_vector(a.begin() + 2 * k, a.end()), b1, limb_base, q1, r1);
+
+            limb_vector x(a.begin(), a.begin() + 2 * k);
+            fold(x, q1, r1, 2 * k);
+
+            limb_vector q0{};
+            limb_vector r0{};
+            divmod_recursive(x.size() > k ? limb_vector(x.begin() + k, x.end()) : limb_vector{}, b1, limb_base, q0, r0);
+
+            x.resize(std::min(x.size(), k));
+            fold(x, q0, r0, k);
+
+            q = std::move(q0);
+            q.resize(std::max(q.size(), k));
+            add_shifted(q, q1.data(), q1.size(), k, limb_base);
+            trim(q);
+
+            r = std::move(x);
+        }
+        /*      Quotient and remainder of u / v. Short divisors and short quotients take the schoolbook path. Otherwise both operands are
+        /*  normalized as in divmod_schoolbook and the dividend is consumed from the top in pieces of the divisor's length, each a recursive
+        /*  division of at most 2n by n limbs.
+        */
+        inline void divmod(const limb_vector& u, const limb_vector& v, std::uint64_t limb_base, limb_vector& q, limb_vector& r) {
+            if (v.size() < DIVIDE_RECURSIVE_THRESHOLD || u.size() < v.size() + DIVIDE_RECURSIVE_THRESHOLD) {
+                divmod_schoolbook(u, v, limb_base, q, r);
+                return;
+            }
+
+            std::uint64_t d{ limb_base / (std::uint64_t{ v.back() } + 1) };
+            std::size_t n{ v.size() };
+
+            limb_vector un{ u };
+            limb_vector vn{ v };
+            mul_1(un, d, 0, limb_base);
+            mul_1(vn, d, 0, limb_base);
+
+            std::size_t offset{ un.size() - n };
+            limb_vector rem(un.begin() + offset, un.end());
+
+            q.clear();
+
+            while (offset > 0) {
+                std::size_t step{ std::min(offset, n) };
+                offset -= step;
+
+                limb_vector x(un.begin() + offset, un.begin() + offset + step);
+                add_shifted(x, rem.data(), rem.size(), step, limb_base);
+                trim(x);
+
+                limb_vector part{};
+                divmod_recursive(x, vn, limb_base, part, rem);
+
+                add_shifted(q, part.data(), part.size(), offset, limb_base);
+            }
+
+            trim(q);
+
+            divmod_1(rem, d, limb_base);
+            r = std::move(rem);
+        }
+
+
+
+        /*      A power of the base, 1 followed by zeros when written out, is all zero limbs below a top limb which is itself a power of the
+        /*  base. Multiplying or dividing by it only moves digits: whole limbs are shifted and the remaining digits cost a single linear pass.
+        /*  The scan starts at the least significant limb, so an ordinary operand is usually rejected after reading one limb.
+        */
+        inline bool is_radix_power(const limb_vector& x, const radix& rad, std::uint64_t& exponent) {
+            if (x.empty())
+                return false;
+
+            for (std::size_t ind{}; ind + 1 < x.size(); ind++) {
+                if (x[ind] != 0)
+                    return false;
+            }
+
+            std::uint64_t top{ x.back() };
+            std::uint64_t digits{};
+
+            while (top % rad.symbols == 0) {
+                top /= rad.symbols;
+                digits++;
+            }
+
+            if (top != 1)
+                return false;
+
+            exponent = (x.size() - 1) * rad.digits_per_limb + digits;
+            return true;
+        }
+        inline std::uint64_t small_power(const radix& rad, std::uint64_t digits) {
+            std::uint64_t result{ 1 };
+
+            while (digits--)
+                result *= rad.symbols;
+
+            return result;
+        }
+        /* x * symbols^digits */
+        inline limb_vector shift_up(const limb_vector& x, std::uint64_t digits, const radix& rad) {
+            if (x.empty())
+                return {};
+
+            limb_vector r(digits / rad.digits_per_limb, 0);
+            r.insert(r.end(), x.begin(), x.end());
+
+            mul_1(r, small_power(rad, digits % rad.digits_per_limb), 0, rad.limb_base);
+            checkpoint(r.size());
+
+            return r;
+        }
+        /* x / symbols^digits, the digits shifted out form the remainder */
+        inline void shift_down(const limb_vector& x, std::uint64_t digits, const radix& rad, limb_vector& q, limb_vector& r) {
+            std::uint64_t whole{ digits / rad.digits_per_limb };
+
+            if (whole >= x.size()) {
+                q.clear();
+                r = x;
+                return;
+            }
+
+            q.assign(x.begin() + whole, x.end());
+            std::uint64_t rem{ divmod_1(q, small_power(rad, digits % rad.digits_per_limb), rad.limb_base) };
+
+            r.assign(x.begin(), x.begin() + whole);
+            r.push_back(static_cast<limb>(rem));
+            trim(r);
+
+            checkpoint(x.size());
+        }
+
+
+
+        /* re-expresses a magnitude from limbs of one radix in limbs of another */
+        inline limb_vector convert(const limb_vector& x, std::uint64_t from_base, std::uint64_t to_base) {
+            if (from_base == to_base)
+                return x;
+
+            limb_vector r{};
+
+            /* every pass below is one sequential carry sweep over r; reserving its final size keeps r from being copied as it grows */
+            r.reserve(static_cast<std::size_t>(static_cast<double>(x.size()) * std::log(static_cast<double>(from_base)) / std::log(static_cast<double>(to_base))) + 2);
+
+            for (std::size_t ind{ x.size() }; ind-- > 0;) {
+                mul_1(r, from_base, x[ind], to_base);
+                checkpoint(r.size());
+            }
+
+            return r;
+        }
+
+
+
+        /* the digits of a magnitude without the leading zeros of its top limb; zero still has one digit */
+        inline std::uint64_t digit_count(const integer& x) {
+            if (x.is_zero())
+                return 1;
+
+            std::uint64_t count{ (x.magnitude.size() - 1) * x.rad.digits_per_limb };
+
+            for (limb top{ x.magnitude.back() }; top; top = static_cast<limb>(top / x.rad.symbols))
+                count++;
+
+            return count;
+        }
+        /*      Splits the first digit_count digits of a magnitude into words of DIGITS_PER_BLOCK digit fields, the layout of digit_block_data.
+        /*  Words are produced least significant first and handed to write(index, word) as soon as they are complete.
+        */
+        template<typename Write>
+        void pack_digits(const integer& x, std::uint64_t digit_count, Write&& write) {
+            const std::uint64_t symbols{ x.rad.symbols };
+            const std::uint64_t per_limb{ x.rad.digits_per_limb };
+
+            std::uint64_t fields{};
+            std::uint64_t digit_ind{};
+
+            for (limb value : x.magnitude) {
+                for (std::uint64_t ind{}; ind < per_limb && digit_ind < digit_count; ind++) {
+                    fields |= std::uint64_t{ value % symbols } << (digit_ind % DIGITS_PER_BLOCK * BITS_PER_DIGIT);
+                    value = static_cast<limb>(value / symbols);
+
+                    if (++digit_ind % DIGITS_PER_BLOCK == 0) {
+                        write(digit_ind / DIGITS_PER_BLOCK - 1, fields);
+                        fields = 0;
+                    }
+                }
+            }
+
+            if (digit_ind % DIGITS_PER_BLOCK)
+                write(digit_ind / DIGITS_PER_BLOCK, fields);
+        }
+        /* the inverse of pack_digits, joins count words read through word_at(index) into limbs of rad */
+        template<typename Read>
+        limb_vector unpack_digits(Read&& word_at, std::uint64_t count, const radix& rad) {
+            const std::uint64_t symbols{ rad.symbols };
+            const std::uint64_t per_limb{ rad.digits_per_limb };
+            const std::uint64_t digit_count{ count * DIGITS_PER_BLOCK };
+
+            auto digit_at{ [&word_at](std::uint64_t ind) -> std::uint64_t {
+                return (word_at(ind / DIGITS_PER_BLOCK) >> (ind % DIGITS_PER_BLOCK * BITS_PER_DIGIT)) & 0xff;
+            } };
+
+            limb_vector r((digit_count + per_limb - 1) / per_limb);
+
+            for (std::uint64_t limb_ind{}; limb_ind < r.size(); limb_ind++) {
+                std::uint64_t first{ limb_ind * per_limb };
+                std::uint64_t last{ std::min(first + per_limb, digit_count) };
+                std::uint64_t value{};
+
+                /* horner's rule from the most significant digit of the limb */
+                for (std::uint64_t ind{ last }; ind-- > first;) {
+                    value = value * symbols + digit_at(ind);
+                }
+
+                r[limb_ind] = static_cast<limb>(value);
+            }
+
+            trim(r);
+            return r;
+        }
+
+
+
+    } /* end detail */
+
+
+
+    inline integer from_uint64(std::uint64_t value, const radix& rad) {
+        integer result{ {}, false, rad };
+
+        while (value) {
+            result.magnitude.push_back(static_cast<limb>(value % rad.limb_base));
+            value /= rad.limb_base;
+        }
+
+        return result;
+    }
+    /* the value of an integer whose magnitude is below 2^64 */
+    inline std::uint64_t to_uint64(const integer& x) {
+        std::uint64_t value{};
+
+        for (std::size_t ind{ x.magnitude.size() }; ind-- > 0;)
+            value = value * x.rad.limb_base + x.magnitude[ind];
+
+        return value;
+    }
+
+
+
+    inline integer rebase(const integer& x, const radix& rad) {
+        if (x.rad == rad)
+            return x;
+
+        /* the limbs already hold the value in the target's limb base, only the digits they are read as change */
+        if (x.rad.limb_base == rad.limb_base)
+            return integer{ x.magnitude, x.negative, rad };
+
+        return integer{ detail::convert(x.magnitude, x.rad.limb_base, rad.limb_base), x.negative, rad };
+    }
+
+
+
+    /* reads the digits of a number into limbs of the number's own base */
+    inline integer load(const number& num) {
+        integer result{ {}, num.negative.load(), make_radix(num.base_size()) };
+
+        if (num.block == nullptr)
+            return result;
+
+        auto word_at{ [&num](std::uint64_t ind) -> std::uint64_t {
+            return *reinterpret_cast<std::uint64_t*>(num.block[ind].data);
+        } };
+
+        result.magnitude = detail::unpack_digits(word_at, num.size, result.rad);
+
+        if (result.is_zero())
+            result.negative = false;
+
+        return result;
+    }
+    /* writes an integer into a number, re-expressing it in the number's base when the radixes differ */
+    inline void store(number& num, const integer& value) {
+        integer x{ rebase(value, make_radix(num.base_size())) };
+
+        std::uint64_t digit_count{ detail::digit_count(x) };
+
+        /* digits are streamed into the blocks as they are produced rather than staged in a copy of the whole number */
+        num.allocate((digit_count + DIGITS_PER_BLOCK - 1) / DIGITS_PER_BLOCK);
+        num.negative.store(x.negative && !x.is_zero());
+
+        detail::pack_digits(x, digit_count, [&num](std::uint64_t ind, std::uint64_t fields) {
+            num.block[ind] = fields;
+        });
+
+        num.publish();
+    }
+
+
+
+    inline integer add(const integer& lhs, const integer& rhs) {
+        const std::uint64_t limb_base{ lhs.rad.limb_base };
+
+        if (lhs.negative == rhs.negative) {
+            return integer{ detail::add(lhs.magnitude.data(), lhs.magnitude.size(), rhs.magnitude.data(), rhs.magnitude.size(), limb_base), lhs.negative, lhs.rad };
+        }
+
+        /* opposite signs, subtract the smaller magnitude from the larger one */
+        int order{ detail::compare(lhs.magnitude, rhs.magnitude) };
+
+        if (order == 0)
+            return integer{ {}, false, lhs.rad };
+
+        const integer& big{ order > 0 ? lhs : rhs };
+        const integer& small{ order > 0 ? rhs : lhs };
+
+        integer result{ big.magnitude, big.negative, lhs.rad };
+        detail::sub_shifted(result.magnitude, small.magnitude.data(), small.magnitude.size(), 0, limb_base);
+
+        return result;
+    }
+    inline integer subtract(const integer& lhs, integer rhs) {
+        if (!rhs.is_zero())
+            rhs.negative = !rhs.negative;
+
+        return add(lhs, rhs);
+    }
+    inline integer square(const integer& value) {
+        return integer{ detail::multiply(value.magnitude, value.magnitude, value.rad.limb_base), false, value.rad };
+    }
+    inline integer multiply(const integer& lhs, const integer& rhs) {
+        integer result{ {}, lhs.negative != rhs.negative, lhs.rad };
+        std::uint64_t digits{};
+
+        if (detail::is_radix_power(rhs.magnitude, rhs.rad, digits))
+            result.magnitude = detail::shift_up(lhs.magnitude, digits, lhs.rad);
+        else if (detail::is_radix_power(lhs.magnitude, lhs.rad, digits))
+            result.magnitude = detail::shift_up(rhs.magnitude, digits, lhs.rad);
+        else
+            result.magnitude = detail::multiply(lhs.magnitude, rhs.magnitude, lhs.rad.limb_base);
+
+        if (result.is_zero())
+            result.negative = false;
+
+        return result;
+    }
+    /* truncating division, the remainder takes the sign of the dividend */
+    inline void divide(const integer& lhs, const integer& rhs, integer& quotient, integer& remainder) {
+        quotient = integer{ {}, false, lhs.rad };
+        remainder = integer{ {}, false, lhs.rad };
+
+        std::uint64_t digits{};
+
+        if (detail::is_radix_power(rhs.magnitude, rhs.rad, digits))
+            detail::shift_down(lhs.magnitude, digits, lhs.rad, quotient.magnitude, remainder.magnitude);
+        else
+            detail::divmod(lhs.magnitude, rhs.magnitude, lhs.rad.limb_base, quotient.magnitude, remainder.magnitude);
+
+        quotient.negative = !quotient.is_zero() && lhs.negative != rhs.negative;
+        remainder.negative = !remainder.is_zero() && lhs.negative;
+    }
+    inline integer divide(const integer& lhs, const integer& rhs) {
+        integer quotient{};
+        integer remainder{};
+
+        divide(lhs, rhs, quotient, remainder);
+
+        return quotient;
+    }
+    inline integer power(const integer& lhs, std::uint64_t e) {
+        integer result{ { 1 }, false, lhs.rad };
+        integer base_power{ lhs };
+
+        /* square and multiply, from the least significant bit of the exponent */
+        while (e) {
+            if (e & 1)
+                result = multiply(result, base_power);
+
+            e >>= 1;
+
+            if (e)
+                base_power = calc::square(base_power);
+        }
+
+        return result;
+    }
+    inline integer power(const integer& lhs, const integer& rhs) {
+        if (rhs.negative)
+            throw std::domain_error{ "Negative exponent" };
+
+        integer exponent{ rebase(rhs, make_radix(2)) };
+
+        if (exponent.magnitude.size() > 2)
+            throw std::overflow_error{ "Exponent too large" };
+
+        std::uint64_t e{};
+        for (std::size_t ind{ exponent.magnitude.size() }; ind-- > 0;)
+            e = (e << 32) | exponent.magnitude[ind];
+
+        return power(lhs, e);
+    }
+
+
+
+} /* end calc */
@@ -0,0 +1,209 @@
+#pragma once
+
+
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <string>
+#include <string_view>
+
+#include "calc_numbers.h"
+#include "calc_arithmetic.h"
+#include "calc_evaluate.h"
+#include "calc_parser.h"
+#include "calc_thread_pool.h"
+
+
+
+namespace calc {
+
+
+
+    /*  base:           The base every expression is read in and every result is written in.
+    /*  threads:        Worker threads evaluating chunks, zero picks one per hardware thread.
+    /*  chunk_bytes:    Input is handed to workers in chunks of whole lines of about this size.
+    /*  chunks_queued:  Chunks allowed in flight per worker before the reader waits on the writer.
+    */
+    struct batch_options {
+        number_base* base{};
+        std::size_t threads{};
+        std::size_t chunk_bytes{ 1 << 16 };
+        std::size_t chunks_queued{ 4 };
+    };
+
+
+
+    namespace detail {
+
+
+
+        /* appends the digits of a value in the symbols of base, most significant first */
+        inline void append_digits(std::string& out, const integer& value, const number_base* base) {
+            const char* symbols{ base->symbol_vec };
+            integer x{ rebase(value, make_radix(std::strlen(symbols))) };
+
+            const std::uint64_t symbol_count{ x.rad.symbols };
+
+            if (x.is_zero()) {
+                out += symbols[0];
+                return;
+            }
+
+            if (x.negative)
+                out += '-';
+
+            char digits[64]{};
+
+            for (std::size_t ind{ x.magnitude.size() }; ind-- > 0;) {
+                std::uint64_t value{ x.magnitude[ind] };
+                std::size_t count{};
+
+                /* every limb but the most significant one is zero padded to its full width */
+                for (std::uint64_t digit{}; digit < x.rad.digits_per_limb; digit++) {
+                    digits[count++] = symbols[value % symbol_count];
+                    value /= symbol_count;
+
+                    if (value == 0 && ind == x.magnitude.size() - 1)
+                        break;
+                }
+
+                while (count)
+                    out += digits[--count];
+            }
+        }
+
+
+
+        /* evaluates newline separated expressions, writing one result or error line per input line */
+        inline std::string evaluate_lines(std::string_view text, number_base* base) {
+            std::string out{};
+            out.reserve(text.size() * 2);
+
+            while (!text.empty()) {
+                std::size_t end{ text.find('\n') };
+                std::string_view line{ text.substr(0, end) };
+
+                text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+
+                if (!line.empty()) {
+                    try {
+                        std::unique_ptr<problem> prob{ parse(line, base) };
+                        append_digits(out, evaluate_value(prob.get()), base);
+                    }
+                    catch (const std::exception& error) {
+                        out += "error: ";
+                        out += error.what();
+                    }
+                }
+
+                out += '\n';
+            }
+
+            return out;
+        }
+
+
+
+        /*      Keeps the results of submitted chunks in input order. Once more chunks are in flight than allowed, the oldest result is waited
+        /*  for and written, which bounds memory while the workers stay busy.
+        */
+        struct ordered_writer {
+            std::FILE* out{};
+            std::size_t limit{};
+            std::deque<std::future<std::string>> pending{};
+
+
+            void push(std::future<std::string>&& result) {
+                pending.emplace_back(std::move(result));
+
+                while (pending.size() > limit)
+                    write_front();
+            }
+            void write_front() {
+                std::string text{ pending.front().get() };
+                pending.pop_front();
+
+                std::fwrite(text.data(), 1, text.size(), out);
+            }
+            void drain() {
+                while (!pending.empty())
+                    write_front();
+
+                std::fflush(out);
+            }
+        };
+
+
+
+    } /* end detail */
+
+
+
+    /* evaluates every line of an in-memory or mapped input */
+    inline void run_batch(std::string_view input, std::FILE* out, const batch_options& options) {
+        thread_pool pool{ options.threads ? options.threads : std::thread::hardware_concurrency() };
+        detail::ordered_writer writer{ out, pool.size() * options.chunks_queued };
+        number_base* base{ options.base };
+
+        while (!input.empty()) {
+            /* cut the chunk after the first newline past chunk_bytes */
+            std::size_t end{ input.size() };
+
+            if (input.size() > options.chunk_bytes) {
+                std::size_t newline{ input.find('\n', options.chunk_bytes) };
+                end = newline == std::string_view::npos ? input.size() : newline + 1;
+            }
+
+            std::string_view chunk{ input.substr(0, end) };
+            input.remove_prefix(end);
+
+            writer.push(pool.submit([chunk, base]() { return detail::evaluate_lines(chunk, base); }));
+        }
+
+        writer.drain();
+    }
+    /* evaluates every line read from a stream until its end */
+    inline void run_batch(std::FILE* in, std::FILE* out, const batch_options& options) {
+        thread_pool pool{ options.threads ? options.threads : std::thread::hardware_concurrency() };
+        detail::ordered_writer writer{ out, pool.size() * options.chunks_queued };
+        number_base* base{ options.base };
+
+        std::string carry{};
+        std::string buffer(options.chunk_bytes, '\0');
+
+        for (;;) {
+            std::size_t read{ std::fread(buffer.data(), 1, buffer.size(), in) };
+
+            if (read == 0)
+                break;
+
+            /* only whole lines are handed out, a partial last line waits for the next read; only the new bytes can end it */
+            std::size_t end{ std::string_view{ buffer.data(), read }.rfind('\n') };
+
+            carry.append(buffer.data(), read);
+
+            if (end == std::string_view::npos)
+                continue;
+
+            std::size_t last{ carry.size() - read + end };
+
+            std::string chunk{ carry.substr(0, last + 1) };
+            carry.erase(0, last + 1);
+
+            writer.push(pool.submit([chunk = std::move(chunk), base]() { return detail::evaluate_lines(chunk, base); }));
+        }
+
+        if (!carry.empty())
+            writer.push(pool.submit([chunk = std::move(carry), base]() { return detail::evaluate_lines(chunk, base); }));
+
+        writer.drain();
+    }
+
+
+
+} /* end calc */
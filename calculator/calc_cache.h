@@ -0,0 +1,209 @@
+#pragma once
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "calc_numbers.h"
+#include "calc_arithmetic.h"
+
+
+
+namespace calc {
+
+
+
+    constexpr std::size_t CACHE_MIN_LIMBS = 64;                 /* steps on smaller operands are recomputed rather than cached */
+    constexpr std::uint64_t CACHE_DEFAULT_BYTES = 64 << 20;     /* limb storage the result cache may hold                      */
+
+
+
+    /*  operand:  The operator of the entry, or the limb base for the first token of a key.
+    /*  term:     The number the operator applies to, nullptr for groups.
+    /*  version:  The term's version when it was read, or the symbol count of the radix for the first token; bases 2, 4, 16 and 256
+    /*            share a limb base.
+    */
+    struct cache_token {
+        std::uint64_t operand{};
+        const number* term{};
+        std::uint64_t version{};
+
+        friend bool operator==(const cache_token& lhs, const cache_token& rhs) {
+            return lhs.operand == rhs.operand && lhs.term == rhs.term && lhs.version == rhs.version;
+        }
+    };
+
+
+
+    /*      Names the value of a group of a problem up to some entry: the radix followed by every entry folded into it, nested groups
+    /*  included. Two keys are equal when the same operators were applied to the same numbers in the same states, and so was the value.
+    /*  Keys are only built for steps worth caching, from the entries first through last of the expression.
+    */
+    struct cache_key {
+        std::vector<cache_token> tokens{};
+        std::uint64_t hash{ 0xcbf29ce484222325 };
+
+
+        cache_key() = default;
+        cache_key(const radix& rad, const std::vector<operation*>& expression, std::size_t first, std::size_t last) {
+            tokens.reserve(last - first + 2);
+            append(cache_token{ rad.limb_base, nullptr, rad.symbols });
+
+            for (std::size_t ind{ first }; ind <= last; ind++) {
+                const number* term{ expression[ind]->term };
+                append(cache_token{ static_cast<std::uint64_t>(expression[ind]->operand), term, term ? term->version.load() : 0 });
+            }
+        }
+
+        void append(const cache_token& token) {
+            tokens.push_back(token);
+
+            /* 64 bit FNV-1a over the three words */
+            for (std::uint64_t word : { token.operand, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(token.term)), token.version }) {
+                hash ^= word;
+                hash *= 0x100000001b3;
+            }
+        }
+
+        friend bool operator==(const cache_key& lhs, const cache_key& rhs) {
+            return lhs.hash == rhs.hash && lhs.tokens == rhs.tokens;
+        }
+    };
+
+
+
+    struct cache_statistics {
+        std::atomic<std::uint64_t> hits{};
+        std::atomic<std::uint64_t> misses{};
+        std::atomic<std::uint64_t> insertions{};
+        std::atomic<std::uint64_t> evictions{};
+    };
+
+
+
+    /*      A bounded least recently used map from keys to the values they name. Values are shared, so a hit only copies a pointer under the
+    /*  lock. Entries of numbers which have since changed are never hit again and age out like any other.
+    */
+    struct result_cache {
+        struct entry {
+            cache_key key{};
+            std::shared_ptr<const integer> value{};
+            std::uint64_t bytes{};
+        };
+
+        std::mutex lock{};
+        std::list<entry> recent{};
+        std::unordered_multimap<std::uint64_t, std::list<entry>::iterator> index{};
+
+        std::uint64_t capacity{ CACHE_DEFAULT_BYTES };
+        std::uint64_t bytes{};
+
+        cache_statistics statistics{};
+
+
+        /* copies the value named by key into value, false on a miss */
+        bool fetch(const cache_key& key, integer& value) {
+            std::shared_ptr<const integer> found{};
+
+            {
+                std::lock_guard<std::mutex> guard{ lock };
+                auto [first, last] { index.equal_range(key.hash) };
+
+                for (auto it{ first }; it != last; it++) {
+                    if (it->second->key == key) {
+                        recent.splice(recent.begin(), recent, it->second);
+                        found = it->second->value;
+                        break;
+                    }
+                }
+            }
+
+            if (!found) {
+                statistics.misses.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            statistics.hits.fetch_add(1, std::memory_order_relaxed);
+            value = *found;
+            return true;
+        }
+        void store(const cache_key& key, const integer& value) {
+            entry item{ key, std::make_shared<const integer>(value), value.magnitude.size() * sizeof(limb) + key.tokens.size() * sizeof(cache_token) };
+
+            std::lock_guard<std::mutex> guard{ lock };
+
+            if (item.bytes > capacity)
+                return;
+
+            auto [first, last] { index.equal_range(key.hash) };
+
+            for (auto it{ first }; it != last; it++) {
+                if (it->second->key == key)
+                    return;
+            }
+
+            bytes += item.bytes;
+            recent.push_front(std::move(item));
+            index.emplace(key.hash, recent.begin());
+
+            statistics.insertions.fetch_add(1, std::memory_order_relaxed);
+
+            evict();
+        }
+
+        void resize(std::uint64_t new_capacity) {
+            std::lock_guard<std::mutex> guard{ lock };
+            capacity = new_capacity;
+
+            evict();
+        }
+        void clear() {
+            std::lock_guard<std::mutex> guard{ lock };
+            recent.clear();
+            index.clear();
+            bytes = 0;
+        }
+
+
+
+        /* drops the least recently used entries until the cache fits its capacity, the caller holds the lock */
+        void evict() {
+            while (bytes > capacity && !recent.empty()) {
+                entry& oldest{ recent.back() };
+                auto [first, last] { index.equal_range(oldest.key.hash) };
+
+                for (auto it{ first }; it != last; it++) {
+                    if (it->second == std::prev(recent.end())) {
+                        index.erase(it);
+                        break;
+                    }
+                }
+
+                bytes -= oldest.bytes;
+                recent.pop_back();
+
+                statistics.evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /*      The cache shared by every evaluation. It outlives the main thread's pool cache, so the limbs of its entries are released after
+    /*  the pool has been torn down and go straight back to the global allocator.
+    */
+    inline result_cache& evaluation_cache() {
+        static result_cache cache{};
+        return cache;
+    }
+    inline const cache_statistics& cache_stats() {
+        return evaluation_cache().statistics;
+    }
+
+
+
+} /* end calc */
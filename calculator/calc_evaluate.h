@@ -0,0 +1,370 @@
+#pragma once
+
+
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "calc_numbers.h"
+#include "calc_arithmetic.h"
+#include "calc_cache.h"
+#include "calc_gcd.h"
+#include "calc_reduce.h"
+
+
+
+namespace calc {
+
+
+
+    namespace detail {
+
+
+
+        inline integer apply(const integer& lhs, const operand_type& operand, const integer& rhs) {
+            switch (operand) {
+            case operand_type::exp:
+                return power(lhs, rhs);
+            case operand_type::mul:
+                return multiply(lhs, rhs);
+            case operand_type::div:
+                return divide(lhs, rhs);
+            case operand_type::add:
+                return add(lhs, rhs);
+            case operand_type::sub:
+                return subtract(lhs, rhs);
+            case operand_type::gcd:
+                return gcd(lhs, rhs);
+            case operand_type::lcm:
+                return lcm(lhs, rhs);
+            case operand_type::modinv:
+                return modinv(lhs, rhs);
+            default:
+                throw std::invalid_argument{ "Missing operator" };
+            }
+        }
+
+
+
+        /*  value:     The running result of the current parenthesised group.
+        /*  has_value: False until the group's first term has been read.
+        /*  pending:   The operator which combines the value with the next group.
+        /*  source:    The term the value was loaded from while no operator has been applied to it yet.
+        /*  start:     The first entry of the group, the value's cache key is built from the entries since.
+        */
+        struct evaluation_frame {
+            integer value{};
+            bool has_value{};
+            operand_type pending{};
+            const number* source{};
+            std::size_t start{};
+        };
+        inline void fold(evaluation_frame& frame, const operand_type& operand, integer&& value) {
+            if (frame.has_value) {
+                frame.value = apply(frame.value, operand, value);
+                return;
+            }
+
+            /* a leading subtraction negates the first term of a group */
+            if (operand == operand_type::sub && !value.is_zero())
+                value.negative = !value.negative;
+            else if (operand != operand_type::unknown && operand != operand_type::add && operand != operand_type::sub)
+                throw std::invalid_argument{ "Missing left operand" };
+
+            frame.value = std::move(value);
+            frame.has_value = true;
+        }
+
+
+
+        /*      The length of the run of entries, starting at first, which apply the associative operator of expression[first] directly to a
+        /*  term. Subtractions count as additions of negated terms.
+        */
+        inline std::size_t chain_length(const std::vector<operation*>& expression, std::size_t first) {
+            auto additive{ [](const operand_type& operand) {
+                return operand == operand_type::add || operand == operand_type::sub;
+            } };
+
+            const operand_type operand{ expression[first]->operand };
+
+            if (operand != operand_type::mul && !additive(operand))
+                return 0;
+
+            std::size_t last{ first };
+
+            while (last < expression.size() && expression[last]->term != nullptr
+                && (operand == operand_type::mul ? expression[last]->operand == operand_type::mul : additive(expression[last]->operand)))
+                last++;
+
+            return last - first;
+        }
+
+
+
+        /*      Whether applying operand to a value of value_limbs and an operand of operand_limbs costs enough to be worth a cache lookup.
+        /*  Sums are linear and cheaper to redo than to copy out of the cache.
+        */
+        inline bool worth_caching(const operand_type& operand, std::size_t value_limbs, std::size_t operand_limbs) {
+            if (operand == operand_type::add || operand == operand_type::sub)
+                return false;
+
+            return value_limbs + operand_limbs >= CACHE_MIN_LIMBS;
+        }
+        /* the limbs of rad a term takes up, from the size of its block chain */
+        inline std::size_t limbs_of(const number& term, const radix& rad) {
+            return static_cast<std::size_t>(term.size * DIGITS_PER_BLOCK / rad.digits_per_limb);
+        }
+
+
+
+        /*      Walks the serialized expression from first to last. Every entry folds its term into the running value of the innermost group
+        /*  with its operator; see the comment above number's operator overloads for the layout. All terms are re-expressed in the radix of the
+        /*  result so that mixed bases can be combined. Only long runs of products or sums are regrouped, as their operators are associative.
+        /*
+        /*      Costly steps look their result up in the shared result cache first and store it afterwards, keyed by the entries of the group
+        /*  so far. This eliminates common subexpressions within a problem and repeated ones across problems; any change to a term changes its
+        /*  version and so the key. Keys naming terms the problem owns, such as the literals of a parsed line, can not be hit once the problem
+        /*  is gone; such problems keep their steps in a cache of their own, made on first use, instead of crowding out the shared one.
+        */
+        inline integer evaluate_expression(const problem& prob, const radix& rad, evaluation_control* control) {
+            std::optional<result_cache> own_cache{};
+
+            auto cache{ [&prob, &own_cache]() -> result_cache& {
+                if (prob.literals.empty())
+                    return evaluation_cache();
+
+                if (!own_cache)
+                    own_cache.emplace();
+
+                return *own_cache;
+            } };
+
+            std::vector<evaluation_frame> frames(1);
+            cache_key key{};
+
+            for (std::size_t ind{}; ind < prob.expression.size(); ind++) {
+                const operation* op{ prob.expression[ind] };
+                evaluation_frame& frame{ frames.back() };
+
+                switch (op->operand) {
+                case operand_type::oparen:
+                    frames.push_back(evaluation_frame{ .start = ind + 1 });
+                    continue;
+                case operand_type::cparen: {
+                    if (frames.size() < 2)
+                        throw std::invalid_argument{ "Unbalanced parentheses" };
+
+                    evaluation_frame group{ std::move(frames.back()) };
+                    frames.pop_back();
+
+                    if (!group.has_value)
+                        throw std::invalid_argument{ "Empty parentheses" };
+
+                    evaluation_frame& parent{ frames.back() };
+                    bool cached{ parent.has_value && worth_caching(parent.pending, parent.value.magnitude.size(), group.value.magnitude.size()) };
+
+                    parent.source = nullptr;
+
+                    if (cached) {
+                        key = cache_key{ rad, prob.expression, parent.start, ind };
+
+                        if (cache().fetch(key, parent.value))
+                            break;
+                    }
+
+                    fold(parent, parent.pending, std::move(group.value));
+
+                    if (cached)
+                        cache().store(key, parent.value);
+
+                    break;
+                }
+                default:
+                    if (op->term == nullptr) {
+                        frame.pending = op->operand;
+                        continue;
+                    }
+
+                    /* a long chain of products or sums continuing the value is reduced as a balanced tree, see calc_reduce.h */
+                    if (std::size_t run{ frame.has_value ? chain_length(prob.expression, ind) : 0 }; run >= REBALANCE_MIN_TERMS) {
+                        std::size_t operand_limbs{};
+
+                        for (std::size_t term_ind{ ind }; term_ind < ind + run; term_ind++)
+                            operand_limbs += limbs_of(*prob.expression[term_ind]->term, rad);
+
+                        frame.source = nullptr;
+                        ind += run - 1;
+
+                        if (control)
+                            control->stages_completed.fetch_add(run - 1);
+
+                        bool cached{ worth_caching(op->operand, frame.value.magnitude.size(), operand_limbs) };
+
+                        if (cached) {
+                            key = cache_key{ rad, prob.expression, frame.start, ind };
+
+                            if (cache().fetch(key, frame.value))
+                                break;
+                        }
+
+                        std::vector<integer> leaves{};
+                        leaves.reserve(run + 1);
+                        leaves.push_back(std::move(frame.value));
+
+                        for (std::size_t term_ind{ ind + 1 - run }; term_ind <= ind; term_ind++) {
+                            const operation* term_op{ prob.expression[term_ind] };
+                            integer leaf{ rebase(load(*term_op->term), rad) };
+
+                            if (term_op->operand == operand_type::sub && !leaf.is_zero())
+                                leaf.negative = !leaf.negative;
+
+                            leaves.push_back(std::move(leaf));
+                        }
+
+                        frame.value = op->operand == operand_type::mul ? product(std::move(leaves)) : sum(std::move(leaves));
+
+                        if (cached)
+                            cache().store(key, frame.value);
+
+                        break;
+                    }
+
+                    bool cached{ frame.has_value && worth_caching(op->operand, frame.value.magnitude.size(), limbs_of(*op->term, rad)) };
+
+                    if (cached) {
+                        key = cache_key{ rad, prob.expression, frame.start, ind };
+
+                        if (cache().fetch(key, frame.value)) {
+                            frame.source = nullptr;
+                            break;
+                        }
+                    }
+
+                    /* 'a * a' on the same number is a square, and the term does not need to be loaded twice */
+                    if (frame.has_value && frame.source == op->term && op->operand == operand_type::mul) {
+                        frame.value = square(frame.value);
+                        frame.source = nullptr;
+                    }
+                    else {
+                        frame.source = frame.has_value || op->operand == operand_type::sub ? nullptr : op->term;
+                        fold(frame, op->operand, rebase(load(*op->term), rad));
+                    }
+
+                    if (cached)
+                        cache().store(key, frame.value);
+
+                    break;
+                }
+
+                if (control) {
+                    control->stages_completed.fetch_add(1);
+                    poll_control();
+                }
+            }
+
+            if (frames.size() != 1 || !frames.back().has_value)
+                throw std::invalid_argument{ "Incomplete expression" };
+
+            return std::move(frames.back().value);
+        }
+        inline std::uint64_t count_stages(const problem& prob) {
+            std::uint64_t stages{};
+
+            for (const operation* op : prob.expression) {
+                if (op->term != nullptr || op->operand == operand_type::cparen)
+                    stages++;
+            }
+
+            return stages;
+        }
+        inline number_base* result_base(const problem& prob) {
+            for (const operation* op : prob.expression) {
+                if (op->term != nullptr)
+                    return op->term->base;
+            }
+
+            throw std::invalid_argument{ "Empty problem" };
+        }
+
+
+
+    } /* end detail */
+
+
+
+    /*      Evaluates a problem on the calling thread. The result is written in the base of the expression's first term. When a control block
+    /*  is given, progress is reported through it and the evaluation throws evaluation_cancelled once it is cancelled or its deadline passes.
+    */
+    inline integer evaluate_value(problem* prob, evaluation_control* control = nullptr) {
+        number_base* base{ detail::result_base(*prob) };
+        detail::control_scope scope{ control };
+
+        if (control)
+            control->stages_total.store(detail::count_stages(*prob));
+
+        return detail::evaluate_expression(*prob, make_radix(std::strlen(base->symbol_vec)), control);
+    }
+    inline std::unique_ptr<number> evaluate(problem* prob, evaluation_control* control = nullptr) {
+        integer value{ evaluate_value(prob, control) };
+
+        std::unique_ptr<number> result{ std::make_unique<number>(detail::result_base(*prob)) };
+        store(*result, value);
+
+        return result;
+    }
+
+
+
+    /*      Evaluates a problem on another thread. Keep the control block to watch progress or to cancel; the future then rethrows
+    /*  evaluation_cancelled. The problem and its terms must outlive the evaluation.
+    */
+    inline std::future<std::unique_ptr<number>> evaluate_async(problem* prob, std::shared_ptr<evaluation_control> control = std::make_shared<evaluation_control>()) {
+        return std::async(std::launch::async, [prob, control]() {
+            return evaluate(prob, control.get());
+        });
+    }
+
+
+
+    /*  co_await evaluate_awaitable(prob) suspends the coroutine, evaluates on another thread and resumes the coroutine on that thread. */
+    struct evaluation_awaitable {
+        problem* prob{};
+        std::shared_ptr<evaluation_control> control{};
+
+        std::unique_ptr<number> result{};
+        std::exception_ptr error{};
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            std::thread{ [this, handle]() {
+                try {
+                    result = evaluate(prob, control.get());
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+
+                handle.resume();
+            } }.detach();
+        }
+        std::unique_ptr<number> await_resume() {
+            if (error)
+                std::rethrow_exception(error);
+
+            return std::move(result);
+        }
+    };
+    inline evaluation_awaitable evaluate_awaitable(problem* prob, std::shared_ptr<evaluation_control> control = std::make_shared<evaluation_control>()) {
+        return evaluation_awaitable{ prob, std::move(control) };
+    }
+
+
+
+} /* end calc */
@@ -0,0 +1,474 @@
+#pragma once
+
+
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "calc_numbers.h"
+#include "calc_arithmetic.h"
+
+
+
+namespace calc {
+
+
+
+    constexpr std::size_t HGCD_THRESHOLD = 96; /* limbs; below this the half-gcd recursion stops and Lehmer steps take over */
+
+
+
+    namespace detail {
+
+
+
+        inline integer from_int64(std::int64_t value, const radix& rad) {
+            integer result{ from_uint64(value < 0 ? std::uint64_t{} - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value), rad) };
+            result.negative = value < 0;
+
+            return result;
+        }
+        inline integer negate(integer value) {
+            if (!value.is_zero())
+                value.negative = !value.negative;
+
+            return value;
+        }
+        inline integer magnitude_of(integer value) {
+            value.negative = false;
+            return value;
+        }
+
+
+
+        /*      Lehmer's idea: the first quotients of Euclid's algorithm on a and b only depend on their leading digits. Knuth's algorithm L
+        /*  (TAOCP vol. 2, 4.5.2) runs Euclid on single word approximations â = a / D and b̂ = b / D for a common divisor D and stops as soon as a
+        /*  quotient could differ for the exact values. The cofactors then replace many multi-precision divisions by one linear combination,
+        /*  (a', b') = (A a + B b, C a + D b).
+        /*
+        /*  The approximations are the two leading limbs of a, shifted right so that â < 2^62; every cofactor and sum stays within a
+        /*  std::int64_t.
+        */
+        struct lehmer_cofactors {
+            std::int64_t m[2][2]{ { 1, 0 }, { 0, 1 } };
+            int det{ 1 };
+        };
+        inline bool lehmer(const limb_vector& a, const limb_vector& b, std::uint64_t limb_base, lehmer_cofactors& cof) {
+            std::size_t n{ a.size() };
+
+            if (n < 2 || b.size() + 1 < n)
+                return false;
+
+            std::uint64_t va{ std::uint64_t{ a[n - 1] } * limb_base + a[n - 2] };
+            std::uint64_t vb{ (b.size() == n ? std::uint64_t{ b[n - 1] } * limb_base : 0) + b[n - 2] };
+
+            while (va >= (std::uint64_t{ 1 } << 62)) {
+                va >>= 1;
+                vb >>= 1;
+            }
+
+            std::int64_t ah{ static_cast<std::int64_t>(va) };
+            std::int64_t bh{ static_cast<std::int64_t>(vb) };
+            std::int64_t A{ 1 }, B{ 0 }, C{ 0 }, D{ 1 };
+            int det{ 1 };
+
+            while (bh + C != 0 && bh + D != 0) {
+                std::int64_t q{ (ah + A) / (bh + C) };
+
+                if (q != (ah + B) / (bh + D))
+                    break;
+
+                std::int64_t t{ A - q * C };
+                A = C;
+                C = t;
+
+                t = B - q * D;
+                B = D;
+                D = t;
+
+                t = ah - q * bh;
+                ah = bh;
+                bh = t;
+
+                det = -det;
+            }
+
+            cof = lehmer_cofactors{ { { A, B }, { C, D } }, det };
+
+            return B != 0;
+        }
+        /* x * a + y * b for word sized x and y */
+        inline integer combine(std::int64_t x, const integer& a, std::int64_t y, const integer& b) {
+            return add(multiply(from_int64(x, a.rad), a), multiply(from_int64(y, a.rad), b));
+        }
+
+
+
+        /*  hgcd_matrix: The unimodular matrix M of a reduction, (a; b) = M (a'; b'), with det the sign of its determinant. */
+        struct hgcd_matrix {
+            integer m[2][2]{};
+            int det{ 1 };
+
+            explicit hgcd_matrix(const radix& rad) {
+                m[0][0] = integer{ { 1 }, false, rad };
+                m[0][1] = integer{ {}, false, rad };
+                m[1][0] = integer{ {}, false, rad };
+                m[1][1] = integer{ { 1 }, false, rad };
+            }
+        };
+
+        /* (a; b) = M^-1 (a; b), using M^-1 = det * adj(M) */
+        inline void apply_inverse(const hgcd_matrix& M, integer& a, integer& b) {
+            integer alpha{ subtract(multiply(M.m[1][1], a), multiply(M.m[0][1], b)) };
+            integer beta{ subtract(multiply(M.m[0][0], b), multiply(M.m[1][0], a)) };
+
+            a = M.det < 0 ? negate(std::move(alpha)) : std::move(alpha);
+            b = M.det < 0 ? negate(std::move(beta)) : std::move(beta);
+        }
+        /* M = M * N */
+        inline void compose(hgcd_matrix& M, const hgcd_matrix& N) {
+            for (integer* row : { M.m[0], M.m[1] }) {
+                integer left{ add(multiply(row[0], N.m[0][0]), multiply(row[1], N.m[1][0])) };
+                integer right{ add(multiply(row[0], N.m[0][1]), multiply(row[1], N.m[1][1])) };
+
+                row[0] = std::move(left);
+                row[1] = std::move(right);
+            }
+
+            M.det *= N.det;
+        }
+        /* restores a >= b >= 0 by negating or swapping the matching columns of M, which keeps (a; b) = M (a'; b') */
+        inline void normalize(hgcd_matrix& M, integer& a, integer& b) {
+            for (int col{}; col < 2; col++) {
+                integer& value{ col == 0 ? a : b };
+
+                if (!value.negative)
+                    continue;
+
+                value.negative = false;
+                M.m[0][col] = negate(std::move(M.m[0][col]));
+                M.m[1][col] = negate(std::move(M.m[1][col]));
+                M.det = -M.det;
+            }
+
+            if (compare(a.magnitude, b.magnitude) < 0) {
+                std::swap(a, b);
+                std::swap(M.m[0][0], M.m[0][1]);
+                std::swap(M.m[1][0], M.m[1][1]);
+                M.det = -M.det;
+            }
+        }
+        /* (a, b) = (b, a mod b) and M = M * [q 1; 1 0] */
+        inline void euclid_step(hgcd_matrix& M, integer& a, integer& b) {
+            integer q{};
+            integer r{};
+            divide(a, b, q, r);
+
+            for (integer* row : { M.m[0], M.m[1] }) {
+                integer left{ add(multiply(row[0], q), row[1]) };
+                row[1] = std::move(row[0]);
+                row[0] = std::move(left);
+            }
+
+            M.det = -M.det;
+
+            a = std::move(b);
+            b = std::move(r);
+        }
+        /* one Lehmer step folded into M; M = M * L^-1 with L^-1 = det * adj(L) */
+        inline bool lehmer_step(hgcd_matrix& M, integer& a, integer& b) {
+            lehmer_cofactors cof{};
+
+            if (!lehmer(a.magnitude, b.magnitude, a.rad.limb_base, cof))
+                return false;
+
+            integer alpha{ combine(cof.m[0][0], a, cof.m[0][1], b) };
+            integer beta{ combine(cof.m[1][0], a, cof.m[1][1], b) };
+
+            hgcd_matrix inverse{ a.rad };
+            inverse.m[0][0] = from_int64(cof.det * cof.m[1][1], a.rad);
+            inverse.m[0][1] = from_int64(-cof.det * cof.m[0][1], a.rad);
+            inverse.m[1][0] = from_int64(-cof.det * cof.m[1][0], a.rad);
+            inverse.m[1][1] = from_int64(cof.det * cof.m[0][0], a.rad);
+            inverse.det = cof.det;
+
+            compose(M, inverse);
+
+            a = std::move(alpha);
+            b = std::move(beta);
+            normalize(M, a, b);
+
+            return true;
+        }
+
+
+
+        inline integer high_part(const integer& x, std::size_t limbs) {
+            if (limbs >= x.magnitude.size())
+                return integer{ {}, false, x.rad };
+
+            return integer{ limb_vector(x.magnitude.begin() + limbs, x.magnitude.end()), false, x.rad };
+        }
+
+
+
+        /*      Half-gcd: reduces a >= b >= 0 of n limbs until b fits in s = n / 2 + 1 limbs and returns the matrix of the reduction, in time
+        /*  proportional to a multiplication rather than the square of the size. The quotients of Euclid's algorithm on the top half of a and b
+        /*  are, apart from the last few, the quotients for a and b themselves, so the top n / 2 limbs are reduced recursively and the matrix is
+        /*  applied to the full operands, followed by a second recursion on what remains. A matrix which went a quotient too far only costs
+        /*  efficiency: every matrix is unimodular and gcd(a, b) is unchanged by it.
+        */
+        inline void hgcd(integer& a, integer& b, hgcd_matrix& M) {
+            std::size_t n{ a.magnitude.size() };
+            std::size_t s{ n / 2 + 1 };
+
+            if (b.magnitude.size() <= s)
+                return;
+
+            if (n >= HGCD_THRESHOLD) {
+                std::size_t p{ n / 2 };
+
+                integer a_hi{ high_part(a, p) };
+                integer b_hi{ high_part(b, p) };
+                hgcd_matrix M1{ a.rad };
+                hgcd(a_hi, b_hi, M1);
+
+                apply_inverse(M1, a, b);
+                normalize(M1, a, b);
+                compose(M, M1);
+
+                if (b.magnitude.size() <= s)
+                    return;
+
+                euclid_step(M, a, b);
+
+                if (b.magnitude.size() <= s)
+                    return;
+
+                std::size_t m{ a.magnitude.size() };
+                std::size_t p2{ 2 * s > m ? 2 * s - m : 0 };
+
+                a_hi = high_part(a, p2);
+                b_hi = high_part(b, p2);
+                hgcd_matrix M2{ a.rad };
+                hgcd(a_hi, b_hi, M2);
+
+                apply_inverse(M2, a, b);
+                normalize(M2, a, b);
+                compose(M, M2);
+            }
+
+            /* finish with Lehmer steps, or single divisions where the leading limbs do not settle a quotient */
+            while (b.magnitude.size() > s) {
+                if (!lehmer_step(M, a, b))
+                    euclid_step(M, a, b);
+
+                checkpoint(a.magnitude.size());
+            }
+        }
+
+
+
+        /*      Shared by gcd and gcdext. Reduces a >= b >= 0 to (g, 0). When track is given, (u0; u1) holds the coefficients of the original a
+        /*  in the current pair and is updated alongside it.
+        */
+        inline void reduce(integer& a, integer& b, integer* u0, integer* u1) {
+            while (!b.is_zero()) {
+                if (a.magnitude.size() >= HGCD_THRESHOLD && b.magnitude.size() > a.magnitude.size() / 2 + 1) {
+                    hgcd_matrix M{ a.rad };
+                    std::size_t a_before{ a.magnitude.size() };
+                    std::size_t b_before{ b.magnitude.size() };
+
+                    hgcd(a, b, M);
+
+                    if (u0)
+                        apply_inverse(M, *u0, *u1);
+
+                    /* hgcd may finish the reduction, or shrink only b; either way the pair is no longer the one it was given */
+                    if (b.is_zero() || a.magnitude.size() < a_before || b.magnitude.size() < b_before)
+                        continue;
+                }
+
+                lehmer_cofactors cof{};
+
+                if (lehmer(a.magnitude, b.magnitude, a.rad.limb_base, cof)) {
+                    integer alpha{ combine(cof.m[0][0], a, cof.m[0][1], b) };
+                    integer beta{ combine(cof.m[1][0], a, cof.m[1][1], b) };
+
+                    a = std::move(alpha);
+                    b = std::move(beta);
+
+                    if (u0) {
+                        integer v0{ combine(cof.m[0][0], *u0, cof.m[0][1], *u1) };
+                        integer v1{ combine(cof.m[1][0], *u0, cof.m[1][1], *u1) };
+
+                        *u0 = std::move(v0);
+                        *u1 = std::move(v1);
+                    }
+                }
+                else {
+                    integer q{};
+                    integer r{};
+                    divide(a, b, q, r);
+
+                    a = std::move(b);
+                    b = std::move(r);
+
+                    if (u0) {
+                        integer next{ subtract(*u0, multiply(q, *u1)) };
+
+                        *u0 = std::move(*u1);
+                        *u1 = std::move(next);
+                    }
+                }
+
+                checkpoint(a.magnitude.size());
+            }
+        }
+
+
+
+    } /* end detail */
+
+
+
+    /* the greatest common divisor of |lhs| and |rhs|, gcd(0, 0) = 0 */
+    inline integer gcd(const integer& lhs, const integer& rhs) {
+        integer a{ detail::magnitude_of(lhs) };
+        integer b{ detail::magnitude_of(rebase(rhs, lhs.rad)) };
+
+        if (detail::compare(a.magnitude, b.magnitude) < 0)
+            std::swap(a, b);
+
+        detail::reduce(a, b, nullptr, nullptr);
+
+        return a;
+    }
+    /* the extended gcd, g = gcd(lhs, rhs) = s * lhs + t * rhs */
+    inline void gcdext(const integer& lhs, const integer& rhs, integer& g, integer& s, integer& t) {
+        integer a{ detail::magnitude_of(lhs) };
+        integer b{ detail::magnitude_of(rebase(rhs, lhs.rad)) };
+
+        bool swapped{ detail::compare(a.magnitude, b.magnitude) < 0 };
+
+        if (swapped)
+            std::swap(a, b);
+
+        const integer first{ a };
+        const integer second{ b };
+
+        integer u0{ { 1 }, false, lhs.rad };
+        integer u1{ {}, false, lhs.rad };
+
+        detail::reduce(a, b, &u0, &u1);
+
+        g = std::move(a);
+
+        /* only the coefficients of the first operand were tracked, the second follows from g = u0 * first + v * second */
+        integer v{ {}, false, lhs.rad };
+
+        if (!second.is_zero())
+            v = divide(subtract(g, multiply(u0, first)), second);
+        else if (first.is_zero())
+            u0 = integer{ {}, false, lhs.rad };
+
+        s = swapped ? std::move(v) : std::move(u0);
+        t = swapped ? std::move(u0) : std::move(v);
+
+        if (lhs.negative)
+            s = detail::negate(std::move(s));
+        if (rhs.negative)
+            t = detail::negate(std::move(t));
+    }
+    /* the least common multiple of |lhs| and |rhs|, zero when either is zero */
+    inline integer lcm(const integer& lhs, const integer& rhs) {
+        if (lhs.is_zero() || rhs.is_zero())
+            return integer{ {}, false, lhs.rad };
+
+        integer result{ multiply(divide(lhs, gcd(lhs, rhs)), rebase(rhs, lhs.rad)) };
+        result.negative = false;
+
+        return result;
+    }
+    /* the inverse of value modulo |modulus| in [0, |modulus|), throws when gcd(value, modulus) != 1 */
+    inline integer modinv(const integer& value, const integer& modulus) {
+        if (modulus.is_zero())
+            throw std::domain_error{ "Division by zero" };
+
+        integer g{};
+        integer s{};
+        integer t{};
+
+        gcdext(value, modulus, g, s, t);
+
+        if (g.magnitude.size() != 1 || g.magnitude[0] != 1)
+            throw std::domain_error{ "Not invertible" };
+
+        integer m{ detail::magnitude_of(rebase(modulus, value.rad)) };
+        integer q{};
+        integer r{};
+
+        divide(s, m, q, r);
+
+        return r.negative ? add(r, m) : r;
+    }
+
+
+
+    /*      Problem builders, following the operator overloads of number. gcd and lcm commute and append to an existing problem, modinv
+    /*  does not and wraps a problem on its right in parentheses.
+    */
+    inline problem* gcd(number& lhs, number& rhs) {
+        problem* p{ new problem{} };
+
+        p->expression.emplace_back(new operation{ &lhs, operand_type::unknown });
+        p->expression.emplace_back(new operation{ &rhs, operand_type::gcd });
+
+        return p;
+    }
+    inline problem* gcd(number& lhs, problem* rhs) {
+        rhs->expression.emplace_back(new operation{ &lhs, operand_type::gcd });
+        return rhs;
+    }
+    inline problem* gcd(problem* lhs, number& rhs) {
+        lhs->expression.emplace_back(new operation{ &rhs, operand_type::gcd });
+        return lhs;
+    }
+
+    inline problem* lcm(number& lhs, number& rhs) {
+        problem* p{ new problem{} };
+
+        p->expression.emplace_back(new operation{ &lhs, operand_type::unknown });
+        p->expression.emplace_back(new operation{ &rhs, operand_type::lcm });
+
+        return p;
+    }
+    inline problem* lcm(number& lhs, problem* rhs) {
+        rhs->expression.emplace_back(new operation{ &lhs, operand_type::lcm });
+        return rhs;
+    }
+    inline problem* lcm(problem* lhs, number& rhs) {
+        lhs->expression.emplace_back(new operation{ &rhs, operand_type::lcm });
+        return lhs;
+    }
+
+    inline problem* modinv(number& lhs, number& rhs) {
+        problem* p{ new problem{} };
+
+        p->expression.emplace_back(new operation{ &lhs, operand_type::unknown });
+        p->expression.emplace_back(new operation{ &rhs, operand_type::modinv });
+
+        return p;
+    }
+    inline problem* modinv(number& lhs, problem* rhs) {
+        return number::wrap(lhs, operand_type::modinv, rhs);
+    }
+    inline problem* modinv(problem* lhs, number& rhs) {
+        lhs->expression.emplace_back(new operation{ &rhs, operand_type::modinv });
+        return lhs;
+    }
+
+
+
+} /* end calc */
@@ -0,0 +1,214 @@
+#pragma once
+
+
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+namespace calc {
+
+
+
+    /*  mapped_file: A read-only view of a whole file. The pages are brought in by the operating system as they are touched, so a large input
+    /*  can be scanned front to back without first being copied into memory.
+    */
+    struct mapped_file {
+        const char* data{};
+        std::size_t size{};
+
+#ifdef _WIN32
+        HANDLE file{ INVALID_HANDLE_VALUE };
+        HANDLE mapping{};
+#else
+        int file{ -1 };
+#endif
+
+
+        explicit mapped_file(const char* path) {
+#ifdef _WIN32
+            file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                throw std::runtime_error{ std::string{ "Unable to open " } + path };
+
+            LARGE_INTEGER file_size{};
+            if (!GetFileSizeEx(file, &file_size)) {
+                CloseHandle(file);
+                throw std::runtime_error{ std::string{ "Unable to read the size of " } + path };
+            }
+
+            size = static_cast<std::size_t>(file_size.QuadPart);
+
+            /* an empty file can not be mapped */
+            if (size == 0)
+                return;
+
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping == nullptr) {
+                CloseHandle(file);
+                throw std::runtime_error{ std::string{ "Unable to map " } + path };
+            }
+
+            data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (data == nullptr) {
+                CloseHandle(mapping);
+                CloseHandle(file);
+                throw std::runtime_error{ std::string{ "Unable to map " } + path };
+            }
+#else
+            file = ::open(path, O_RDONLY);
+            if (file < 0)
+                throw std::runtime_error{ std::string{ "Unable to open " } + path };
+
+            struct stat info {};
+            if (::fstat(file, &info) != 0) {
+                ::close(file);
+                throw std::runtime_error{ std::string{ "Unable to read the size of " } + path };
+            }
+
+            size = static_cast<std::size_t>(info.st_size);
+
+            /* an empty file can not be mapped */
+            if (size == 0)
+                return;
+
+            void* view{ ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) };
+            if (view == MAP_FAILED) {
+                ::close(file);
+                throw std::runtime_error{ std::string{ "Unable to map " } + path };
+            }
+
+            ::madvise(view, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(view);
+#endif
+        }
+        ~mapped_file() {
+#ifdef _WIN32
+            if (data) UnmapViewOfFile(data);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+            if (data) ::munmap(const_cast<char*>(data), size);
+            if (file >= 0) ::close(file);
+#endif
+        }
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+    };
+
+
+
+    /*  spill_region: Zeroed, writable memory backed by a temporary file instead of the page file or swap. The file is deleted as soon as
+    /*  it is created (or on close on Windows), so nothing is left behind if the process dies. The operating system writes dirty pages back
+    /*  to the file under memory pressure, which lets data larger than RAM be processed in sequential passes.
+    */
+    struct spill_region {
+        void* data{};
+        std::size_t size{};
+
+#ifdef _WIN32
+        HANDLE file{ INVALID_HANDLE_VALUE };
+        HANDLE mapping{};
+#else
+        int file{ -1 };
+#endif
+
+
+        explicit spill_region(std::size_t size, const std::string& directory = {})
+            : size(size)
+        {
+#ifdef _WIN32
+            char temp_dir[MAX_PATH + 1]{};
+            char path[MAX_PATH + 1]{};
+
+            if (directory.empty())
+                GetTempPathA(MAX_PATH, temp_dir);
+
+            if (!GetTempFileNameA(directory.empty() ? temp_dir : directory.c_str(), "clc", 0, path))
+                throw std::runtime_error{ "Unable to create a spill file" };
+
+            file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                throw std::runtime_error{ "Unable to open a spill file" };
+
+            LARGE_INTEGER file_size{};
+            file_size.QuadPart = static_cast<LONGLONG>(size);
+
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, file_size.HighPart, file_size.LowPart, nullptr);
+            if (mapping == nullptr) {
+                CloseHandle(file);
+                throw std::runtime_error{ "Unable to map a spill file" };
+            }
+
+            data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+            if (data == nullptr) {
+                CloseHandle(mapping);
+                CloseHandle(file);
+                throw std::runtime_error{ "Unable to map a spill file" };
+            }
+#else
+            std::string path{ directory };
+
+            if (path.empty()) {
+                const char* temp_dir{ std::getenv("TMPDIR") };
+                path = temp_dir ? temp_dir : "/tmp";
+            }
+
+            path += "/calc-spill-XXXXXX";
+
+            file = ::mkstemp(path.data());
+            if (file < 0)
+                throw std::runtime_error{ "Unable to create a spill file in " + path };
+
+            ::unlink(path.c_str());
+
+            if (::ftruncate(file, static_cast<off_t>(size)) != 0) {
+                ::close(file);
+                throw std::runtime_error{ "Unable to size a spill file" };
+            }
+
+            void* view{ ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) };
+            if (view == MAP_FAILED) {
+                ::close(file);
+                throw std::runtime_error{ "Unable to map a spill file" };
+            }
+
+            data = view;
+#endif
+        }
+        ~spill_region() {
+#ifdef _WIN32
+            UnmapViewOfFile(data);
+            CloseHandle(mapping);
+            CloseHandle(file);
+#else
+            ::munmap(data, size);
+            ::close(file);
+#endif
+        }
+        spill_region(const spill_region&) = delete;
+        spill_region& operator=(const spill_region&) = delete;
+    };
+
+
+
+} /* end calc */
@@ -2,17 +2,25 @@
 
 
 
+#include <algorithm>
 #include <cmath>
 #include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
 #include <mutex>
 #include <string>
 #include <iomanip>
 #include <bitset>
 #include <locale>
+#include <memory>
 #include <codecvt>
+#include <stdexcept>
 #include <vector>
 
+#include "calc_storage.h"
+
 
 
 namespace calc {
@@ -32,10 +40,8 @@ namespace calc {
         std::size_t len{ str.size() + 1 }; /* including null terminator */
         std::wstring wstr(len, L'\0');
 
-        std::size_t converted{};
-
-        /* convert multi-byte string to wide string */
-        mbstowcs_s(&converted, &wstr[0], wstr.size(), str.c_str(), str.size());
+        /* the bits are plain ASCII, each widens to the same wide character */
+        std::copy(str.begin(), str.end(), wstr.begin());
 
         return wstr;
     }
@@ -86,6 +92,10 @@ namespace calc {
 
 
 
+    struct alignas(std::uint64_t) number;
+
+
+
     struct alignas(std::uint64_t) digit_block {
 
         using size_type = std::size_t;
@@ -97,11 +107,12 @@ namespace calc {
         std::atomic<bool> attention{};  /* for multi-threading               */
         digit_block_data* carry_data{}; /* carry storage for multi-threading */
 
+        number* owner{};                /* the number the block belongs to   */
 
 
-        void set_fields(std::uint64_t& new_fields) const {
-            *reinterpret_cast<std::uint64_t*>(data) = new_fields;
-        }
+
+        /* writes through a block give the owning number a new version, see number::touch */
+        void set_fields(std::uint64_t& new_fields) const;
 
 
 
@@ -121,12 +132,8 @@ namespace calc {
 
 
 
-        void operator=(const std::uint64_t& new_fields) {
-            *reinterpret_cast<std::uint64_t*>(data) = new_fields;
-        }
-        void operator|=(const std::uint64_t& new_fields) {
-            *reinterpret_cast<std::uint64_t*>(data) |= new_fields;
-        }
+        void operator=(const std::uint64_t& new_fields);
+        void operator|=(const std::uint64_t& new_fields);
     };
 
 
@@ -139,7 +146,10 @@ namespace calc {
         mul,
         div,
         add,
-        sub
+        sub,
+        gcd,
+        lcm,
+        modinv
     };
     constexpr inline std::wostream& operator<<(std::wostream& lhs, const operand_type& rhs) {
         switch (rhs) {
@@ -157,6 +167,12 @@ namespace calc {
             return lhs << L"add";
         case operand_type::sub:
             return lhs << L"sub";
+        case operand_type::gcd:
+            return lhs << L"gcd";
+        case operand_type::lcm:
+            return lhs << L"lcm";
+        case operand_type::modinv:
+            return lhs << L"modinv";
         default:
             return lhs << L"unknown";
         }
@@ -164,7 +180,23 @@ namespace calc {
 
 
 
-    struct alignas(std::uint64_t) number;
+    inline std::atomic<std::uint64_t> version_counter{ 1 };
+
+    /*      Versions are handed out from one counter, so no two states of any numbers share a version, not even those of a number and its
+    /*  successor at the same address. Threads reserve them in batches to keep off the shared counter.
+    */
+    inline std::uint64_t next_version() {
+        constexpr std::uint64_t batch{ 1024 };
+        thread_local std::uint64_t next{};
+        thread_local std::uint64_t last{};
+
+        if (next == last) {
+            next = version_counter.fetch_add(batch, std::memory_order_relaxed);
+            last = next + batch;
+        }
+
+        return next++;
+    }
 
 
 
@@ -182,6 +214,14 @@ namespace calc {
 
     struct alignas(std::uint64_t) problem {
         std::vector<operation*> expression{};
+
+        /* terms created for the problem itself, e.g. the literals of a parsed expression */
+        std::vector<std::unique_ptr<number>> literals{};
+
+        problem() = default;
+        problem(const problem&) = delete;
+        problem& operator=(const problem&) = delete;
+        ~problem();
     };
 
 
@@ -197,6 +237,10 @@ namespace calc {
         digit_block* block{};
         size_type size{};
 
+        /* set when the chain outgrew the storage budget; the blocks and their data then all live in this spill file */
+        spill_region* spill{};
+        std::uint64_t reserved_bytes{};
+
         /* if false: prevents indexing of blocks */
         std::atomic<bool> threads_may_index{ false };
         /* claims the privilege to write to threads_may_index */
@@ -205,6 +249,11 @@ namespace calc {
         std::condition_variable index_halt_condition{};
         std::atomic<std::uint64_t> indexing_thread_count{};
 
+        /*      Changes whenever the digits do; results computed from this number are cached under it. Writes through the blocks handed
+        /*  out by operator[] and get_block change it too, but a number must not be written while an evaluation reads it.
+        */
+        std::atomic<std::uint64_t> version{ next_version() };
+
 
         number(number_base* base)
             : base(base)
@@ -216,72 +265,33 @@ namespace calc {
 
 
 
-        void free_iterative(digit_block* current_block) {
-            /* loop over blocks */
-            while (current_block != nullptr && current_block != &block[size]) {
-
-                /* clean up the current block */
-                if (current_block->data) {
-                    delete current_block->data;
-                    current_block->data = nullptr;
-                }
-                if (current_block->carry_data) {
-                    delete current_block->carry_data;
-                    current_block->carry_data = nullptr;
-                }
-
-                /*
-                /*  +----------+           +----------+           +----------+           +----------+
-                /*  | Other    |--- ... -->| Previous |- - -X- - >| Current  |--- ... -->| Other    |
-                /*  | Blocks   |<-- ... ---| Block    |<----------| Block    |<-- ... ---| Blocks   |
-                /*  +----------+           +----------+           +----------+           +----------+
-                /*
-                /*  For each block sever the link connecting the previous block to the current block.
-                */
-                if (current_block->prev) {
-                    current_block->prev->next = nullptr;
-                }
-
-                /*
-                /*  +----------+           +----------+           +----------+           +----------+
-                /*  | Other    |--- ... -->| Previous |           | Current  |--- ... -->| Other    |
-                /*  | Blocks   |<-- ... ---| Block    |< - -X- - -| Block    |<-- ... ---| Blocks   |
-                /*  +----------+           +----------+           +----------+           +----------+
-                /*
-                /*  Sever the link which connected the current block with the previous block.
-                */
-                current_block->prev = nullptr;
-
-                /*
-                /*  +----------+           +----------+           +----------+           +----------+
-                /*  | Other    |--- ... -->| Last     |           | First    |--- ... -->| Other    |
-                /*  | Blocks   |<-- ... ---| Block    |           | Block    |<-- ... ---| Blocks   |
-                /*  +----------+           +----------+           +----------+           +----------+
-                /*
-                /*  Explanation:
-                /*
-                /*      Iteration ends when control flows from the intial block to the final block. By severing the first and last block of the
-                /*  chain the result is an eventual nullptr held in current_block. The cain is traversed in order of first to last by following
-                /*  the next pointer of every block. If a block becomes corrupt or lost there is no ledger which tracks the allocation blocks,
-                /*  aside from the chain itself.
-                */
-                current_block = current_block->next;
-            }
+        /* gives the digits a new version after they were written in place */
+        void touch() {
+            version.store(next_version(), std::memory_order_relaxed);
         }
         void free() {
             std::lock_guard<std::mutex> lock{ index_control_lock };
             threads_may_index.store(false);
+            version.store(next_version());
 
             /* normal thread order is sufficent */
             if (indexing_thread_count.load() > 0)
                 indexing_thread_count.wait(0);
 
-            if (block != nullptr) {
-                free_iterative(block);
-                size = 0;
-                delete[] block;
-                block = nullptr;
+            /* the blocks and their data are one allocation, see allocate */
+            if (spill != nullptr) {
+                detail::close_spill(spill);
+                spill = nullptr;
             }
+            else if (block != nullptr) {
+                detail::pool_free(block, storage_bytes(size));
+            }
+
+            block = nullptr;
+            size = 0;
+
+            memory_budget.release(reserved_bytes);
+            reserved_bytes = 0;
         }
 
 
@@ -329,8 +339,6 @@ namespace calc {
         void print() {
             if (block == nullptr) return;
 
-            std::wstring num_str{*this};
-
             std::wcout
                 << L"number" << "\n"
                 << L"  location           : 0x" << std::hex << this << "\n"
@@ -370,6 +378,13 @@ namespace calc {
 
 
 
+        /* the number of unique numerals in the base */
+        std::uint64_t base_size() const {
+            return std::strlen(base->symbol_vec);
+        }
+
+
+
         digit_block* get_block(size_type ind) {
             if (ind > size)
                 return nullptr;
@@ -379,38 +394,48 @@ namespace calc {
 
 
 
-        void assign(const char* str) {
+        /* bytes of one allocation holding count blocks with their data and carry data */
+        static std::uint64_t storage_bytes(std::uint64_t count) {
+            return count * (sizeof(digit_block) + 2 * sizeof(digit_block_data));
+        }
+        /* allocates a zeroed circular chain of digit_blocks_req blocks; indexing stays disabled until the caller publishes the digits */
+        void allocate(std::uint64_t digit_blocks_req) {
             this->free();
 
-            /* calculate the number of digit blocks required to fit all the digits of the string */
-            std::uint64_t str_len{ std::strlen(str) };
-            std::uint64_t digit_blocks_req{ (str_len + DIGITS_PER_BLOCK - 1) / DIGITS_PER_BLOCK };
-
             /* allocate at least one block */
             if (digit_blocks_req == 0) digit_blocks_req = 1;
 
             /* store the size of the list */
             size = digit_blocks_req;
 
-            /* allocate an array of digit_block */
-            block = new digit_block[digit_blocks_req]{};
+            std::uint64_t bytes{ storage_bytes(digit_blocks_req) };
 
-            /* set up the first block's data */
-            block->data = new digit_block_data{};
-            block->carry_data = new digit_block_data{};
+            /*  the blocks, their data and their carry data are laid out back to back in one allocation, taken from the calling thread's
+            /*  storage pool or, over budget, from a spill file
+            /*
+            /*  +--------------------------+--------------------------+--------------------------+
+            /*  | digit_block[size]        | data[size]               | carry_data[size]         |
+            /*  +--------------------------+--------------------------+--------------------------+
+            */
+            if (memory_budget.admit(detail::pool_footprint(static_cast<std::size_t>(bytes)), reserved_bytes)) {
+                block = static_cast<digit_block*>(detail::pool_allocate(static_cast<std::size_t>(bytes)));
+            }
+            else {
+                spill = detail::open_spill(bytes);
+                block = static_cast<digit_block*>(spill->data);
+            }
 
-            /* create additional blocks and link them */
-            for (std::uint64_t ind{ 1 }; ind < digit_blocks_req; ind++) {
-                /*  create a new block
-                /*
-                /*  +----------+           +----------+           +----------+
-                /*  | Other    |--- ... -->| Previous |           | New      |
-                /*  | Blocks   |<-- ... ---| Block    |           | Block    |
-                /*  +----------+           +----------+           +----------+
-                */
-                block[ind].data = new digit_block_data{};
-                block[ind].carry_data = new digit_block_data{};
+            digit_block_data* fields{ reinterpret_cast<digit_block_data*>(block + digit_blocks_req) };
+
+            for (std::uint64_t ind{}; ind < digit_blocks_req; ind++) {
+                new (&block[ind]) digit_block{};
+                block[ind].owner = this;
+                block[ind].data = new (&fields[ind]) digit_block_data{};
+                block[ind].carry_data = new (&fields[digit_blocks_req + ind]) digit_block_data{};
+            }
 
+            /* link the blocks */
+            for (std::uint64_t ind{ 1 }; ind < digit_blocks_req; ind++) {
                 /*  link the new and previous blocks, the previous block's next ptr addresses the new block
                 /*
                 /*  +----------+           +----------+           +----------+
@@ -447,6 +472,20 @@ namespace calc {
             /*  +----------+           +----------+           +----------+           +----------+
             */
             block[0].prev = &block[digit_blocks_req - 1];
+        }
+        /* lets indexing threads see the digits written since allocate */
+        void publish() {
+            std::lock_guard<std::mutex> lock{ index_control_lock };
+            version.store(next_version());
+            threads_may_index.store(true);
+        }
+        void assign(const char* str) {
+            this->assign(str, str ? std::strlen(str) : 0);
+        }
+        void assign(const char* str, std::uint64_t str_len) {
+            /* calculate the number of digit blocks required to fit all the digits of the string */
+            this->allocate((str_len + DIGITS_PER_BLOCK - 1) / DIGITS_PER_BLOCK);
+            negative.store(false);
 
             std::uint64_t digit_ind{ str_len - 1 };
             std::uint64_t symbol_len{ std::strlen(base->symbol_vec) };
@@ -460,7 +499,7 @@ namespace calc {
                 for (std::uint64_t symbol_ind{}; symbol_ind < symbol_len; symbol_ind++) {
                     if (str[str_ind] != base->symbol_vec[symbol_ind]) continue;
 
-                    block[digit_ind / DIGITS_PER_BLOCK] |= symbol_ind << (digit_ind * BITS_PER_DIGIT);
+                    block[digit_ind / DIGITS_PER_BLOCK] |= symbol_ind << (digit_ind % DIGITS_PER_BLOCK * BITS_PER_DIGIT);
 
                     break;
                 }
@@ -469,8 +508,18 @@ namespace calc {
                 digit_ind--;
             }
 
-            std::lock_guard<std::mutex> lock{ index_control_lock };
-            threads_may_index.store(true);
+            this->publish();
+        }
+        /* assigns pre-packed digit fields, one std::uint64_t per block with the least significant block first */
+        void assign(const std::uint64_t* fields, size_type count, bool is_negative = false) {
+            this->allocate(count);
+            negative.store(is_negative);
+
+            for (size_type ind{}; ind < count; ind++) {
+                block[ind] = fields[ind];
+            }
+
+            this->publish();
         }
         void resize(const std::size_t& new_size) {
             if (new_size == 0) {
@@ -482,6 +531,7 @@ namespace calc {
             /* claim control and camly wait */
             std::lock_guard<std::mutex> lock{ index_control_lock };
             threads_may_index.store(false, std::memory_order_acq_rel);
+            version.store(next_version());
 
             /* normal thread order is sufficent */
             if (indexing_thread_count.load() > 0)
@@ -496,14 +546,28 @@ namespace calc {
         /*  the operations of some given expression. This is achived by using a third party class which in the end holds the order of operations.
         /*  Take for example the expression 'a + (b - c) * d' this would become 'b - c * d + a' also written '{ {?, b}, {-, c}, {*, d}, {+, a} }'.
         /*  This is an imutable sequence of explicit order expressing each step to achive the correct awnser.
+        /*
+        /*      Division and subtraction do not commute, so 'a - (b * c)' can not be appended as '{-, a}'. Instead the problem is wrapped in
+        /*  parentheses; entries without a term mark the operator applied to the group and the group's bounds. The expression is written
+        /*  '{ {?, a}, {-, null}, {(, null}, {?, b}, {*, c}, {), null} }'.
         */
+        static problem* wrap(number& lhs, const operand_type& operand, problem* rhs) {
+            rhs->expression.insert(rhs->expression.begin(), {
+                new operation{ &lhs, operand_type::unknown },
+                new operation{ nullptr, operand },
+                new operation{ nullptr, operand_type::oparen }
+                });
+            rhs->expression.emplace_back(new operation{ nullptr, operand_type::cparen });
+
+            return rhs;
+        }
 
         /* multiplication overload */
         friend problem* operator*(number& lhs, number& rhs) {
             problem* p{ new problem{} };
 
-            p->expression.emplace_back(new operation{ &rhs, operand_type::unknown });
-            p->expression.emplace_back(new operation{ &lhs, operand_type::mul });
+            p->expression.emplace_back(new operation{ &lhs, operand_type::unknown });
+            p->expression.emplace_back(new operation{ &rhs, operand_type::mul });
 
             return p;
         }
@@ -520,14 +584,13 @@ namespace calc {
         friend problem* operator/(number& lhs, number& rhs) {
             problem* p{ new problem{} };
 
-            p->expression.emplace_back(new operation{ &rhs, operand_type::unknown });
-            p->expression.emplace_back(new operation{ &lhs, operand_type::div });
+            p->expression.emplace_back(new operation{ &lhs, operand_type::unknown });
+            p->expression.emplace_back(new operation{ &rhs, operand_type::div });
 
             return p;
         }
         friend problem* operator/(number& lhs, problem* rhs) {
-            rhs->expression.emplace_back(new operation{ &lhs, operand_type::div });
-            return rhs;
+            return wrap(lhs, operand_type::div, rhs);
         }
         friend problem* operator/(problem* lhs, number& rhs) {
             lhs->expression.emplace_back(new operation{ &rhs, operand_type::div });
@@ -538,8 +601,8 @@ namespace calc {
         friend problem* operator+(number& lhs, number& rhs) {
             problem* p{ new problem{} };
 
-            p->expression.emplace_back(new operation{ &rhs, operand_type::unknown });
-            p->expression.emplace_back(new operation{ &lhs, operand_type::add });
+            p->expression.emplace_back(new operation{ &lhs, operand_type::unknown });
+            p->expression.emplace_back(new operation{ &rhs, operand_type::add });
 
             return p;
         }
@@ -556,14 +619,13 @@ namespace calc {
         friend problem* operator-(number& lhs, number& rhs) {
             problem* p{ new problem{} };
 
-            p->expression.emplace_back(new operation{ &rhs, operand_type::unknown });
-            p->expression.emplace_back(new operation{ &lhs, operand_type::sub });
+            p->expression.emplace_back(new operation{ &lhs, operand_type::unknown });
+            p->expression.emplace_back(new operation{ &rhs, operand_type::sub });
 
             return p;
         }
         friend problem* operator-(number& lhs, problem* rhs) {
-            rhs->expression.emplace_back(new operation{ &lhs, operand_type::sub });
-            return rhs;
+            return wrap(lhs, operand_type::sub, rhs);
         }
         friend problem* operator-(problem* lhs, number& rhs) {
             lhs->expression.emplace_back(new operation{ &rhs, operand_type::sub });
@@ -579,6 +641,9 @@ namespace calc {
             if (current_block == nullptr)
                 return lhs;
 
+            if (rhs.negative.load())
+                lhs << L'-';
+
             bool found_first_non_zero{};
             std::size_t comma_counter{};
             std::size_t total_digits{};
@@ -601,6 +666,10 @@ namespace calc {
                 }
             }
 
+            /* a single block of zeros is still the number zero */
+            if (!found_first_non_zero && rhs.size == 1)
+                lhs << rhs.base->symbol_vec[0];
+
             current_block = current_block->prev;
 
             while (current_block != rhs.block[0].prev) {
@@ -632,4 +701,26 @@ namespace calc {
 
 
 
+    inline problem::~problem() {
+        for (operation* op : expression)
+            delete op;
+    }
+
+
+
+    inline void digit_block::set_fields(std::uint64_t& new_fields) const {
+        *reinterpret_cast<std::uint64_t*>(data) = new_fields;
+        owner->touch();
+    }
+    inline void digit_block::operator=(const std::uint64_t& new_fields) {
+        *reinterpret_cast<std::uint64_t*>(data) = new_fields;
+        owner->touch();
+    }
+    inline void digit_block::operator|=(const std::uint64_t& new_fields) {
+        *reinterpret_cast<std::uint64_t*>(data) |= new_fields;
+        owner->touch();
+    }
+
+
+
 } /* end calc */
\ No newline at end of file
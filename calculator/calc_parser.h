@@ -0,0 +1,315 @@
+#pragma once
+
+
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "calc_numbers.h"
+
+
+
+namespace calc {
+
+
+
+    struct parse_error : std::invalid_argument {
+        std::size_t position{};
+
+        parse_error(const std::string& what, std::size_t position)
+            : std::invalid_argument(what + " at " + std::to_string(position)), position(position)
+        {
+        }
+    };
+
+
+
+    enum struct token_type {
+        end = 0,
+        numeral,
+        oparen,
+        cparen,
+        exp,
+        mul,
+        div,
+        add,
+        sub
+    };
+
+
+
+    /*  tokenizer: Splits text into numerals and operators. A numeral is the longest run of symbols of the base; whitespace only separates
+    /*  tokens. Every other character is an error, which is why letters are numerals in bases such as base16 and errors in base10.
+    */
+    struct tokenizer {
+        std::string_view text{};
+        std::size_t pos{};
+
+        /* maps a character to its symbol index plus one, zero marks a character which is not a numeral */
+        std::uint8_t symbol_map[256]{};
+
+        token_type type{};
+        std::string_view lexeme{};
+        std::size_t start{};
+
+
+        tokenizer(std::string_view text, const number_base* base)
+            : text(text)
+        {
+            const char* symbols{ base->symbol_vec };
+
+            for (std::size_t ind{}; symbols[ind] != '\0'; ind++)
+                symbol_map[static_cast<unsigned char>(symbols[ind])] = static_cast<std::uint8_t>(ind + 1);
+
+            next();
+        }
+
+
+
+        bool is_numeral(char c) const {
+            return symbol_map[static_cast<unsigned char>(c)] != 0;
+        }
+
+
+
+        void next() {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n'))
+                pos++;
+
+            start = pos;
+
+            if (pos == text.size()) {
+                type = token_type::end;
+                lexeme = {};
+                return;
+            }
+
+            /* numerals take precedence so that a base may use operator characters as symbols */
+            if (is_numeral(text[pos])) {
+                while (pos < text.size() && is_numeral(text[pos]))
+                    pos++;
+
+                type = token_type::numeral;
+                lexeme = text.substr(start, pos - start);
+                return;
+            }
+
+            switch (text[pos]) {
+            case '(': type = token_type::oparen; break;
+            case ')': type = token_type::cparen; break;
+            case '^': type = token_type::exp; break;
+            case '*': type = token_type::mul; break;
+            case '/': type = token_type::div; break;
+            case '+': type = token_type::add; break;
+            case '-': type = token_type::sub; break;
+            default:
+                throw parse_error{ std::string{ "Unexpected character '" } + text[pos] + "'", pos };
+            }
+
+            lexeme = text.substr(start, 1);
+            pos++;
+        }
+    };
+
+
+
+    namespace detail {
+
+
+
+        /*      A fragment is a parsed sub-expression in the serialized form of problem. A single numeral is kept as a bare term until it is
+        /*  known whether it opens a sequence or is the right operand of an operator; anything larger is a sequence of operations. Joining
+        /*  'lhs op rhs' appends to the left fragment and only needs parentheses when the right fragment is not a single term, so left-deep
+        /*  chains such as 'a * b * c' stay flat.
+        */
+        struct fragment {
+            number* term{};
+            std::vector<operation*> ops{};
+        };
+
+
+
+        struct parser {
+            tokenizer tokens;
+            number_base* base{};
+            problem* prob{};
+
+            /* every operation created so far, released if parsing fails before the problem takes ownership */
+            std::vector<operation*> created{};
+            /* a numeral spelled the same way twice is the same term, which lets the evaluator share the work done on it */
+            std::unordered_map<std::string_view, number*> numerals{};
+
+
+            parser(std::string_view text, number_base* base, problem* prob)
+                : tokens(text, base), base(base), prob(prob)
+            {
+            }
+
+
+
+            operation* make(number* term, const operand_type& operand) {
+                return created.emplace_back(new operation{ term, operand });
+            }
+
+
+
+            /* lays a fragment out as operations, the first of which applies the fragment with operand */
+            std::vector<operation*> open(fragment&& frag, const operand_type& operand) {
+                if (frag.term)
+                    return { make(frag.term, operand) };
+
+                if (operand == operand_type::unknown)
+                    return std::move(frag.ops);
+
+                std::vector<operation*> ops{};
+                ops.reserve(frag.ops.size() + 3);
+                ops.emplace_back(make(nullptr, operand));
+                ops.emplace_back(make(nullptr, operand_type::oparen));
+                ops.insert(ops.end(), frag.ops.begin(), frag.ops.end());
+                ops.emplace_back(make(nullptr, operand_type::cparen));
+
+                return ops;
+            }
+            fragment join(fragment&& lhs, const operand_type& operand, fragment&& rhs) {
+                fragment result{ nullptr, open(std::move(lhs), operand_type::unknown) };
+                std::vector<operation*> tail{ open(std::move(rhs), operand) };
+
+                result.ops.insert(result.ops.end(), tail.begin(), tail.end());
+
+                return result;
+            }
+
+
+
+            static int precedence(const token_type& type) {
+                switch (type) {
+                case token_type::add:
+                case token_type::sub:
+                    return 1;
+                case token_type::mul:
+                case token_type::div:
+                    return 2;
+                default:
+                    return 0;
+                }
+            }
+            static operand_type to_operand(const token_type& type) {
+                switch (type) {
+                case token_type::exp: return operand_type::exp;
+                case token_type::mul: return operand_type::mul;
+                case token_type::div: return operand_type::div;
+                case token_type::add: return operand_type::add;
+                case token_type::sub: return operand_type::sub;
+                default: return operand_type::unknown;
+                }
+            }
+
+
+
+            fragment primary() {
+                switch (tokens.type) {
+                case token_type::numeral: {
+                    number*& term{ numerals[tokens.lexeme] };
+
+                    if (term == nullptr) {
+                        term = prob->literals.emplace_back(std::make_unique<number>(base)).get();
+                        term->assign(tokens.lexeme.data(), tokens.lexeme.size());
+                    }
+
+                    tokens.next();
+
+                    return fragment{ term };
+                }
+                case token_type::oparen: {
+                    tokens.next();
+                    fragment inner{ expression(1) };
+
+                    if (tokens.type != token_type::cparen)
+                        throw parse_error{ "Expected ')'", tokens.start };
+
+                    tokens.next();
+
+                    return inner;
+                }
+                case token_type::add:
+                    tokens.next();
+                    return unary();
+                case token_type::end:
+                    throw parse_error{ "Unexpected end of expression", tokens.start };
+                default:
+                    throw parse_error{ "Expected a number", tokens.start };
+                }
+            }
+            /* '^' is right associative and binds tighter than a leading sign, -2^2 is -(2^2) */
+            fragment unary() {
+                if (tokens.type == token_type::sub) {
+                    tokens.next();
+                    return fragment{ nullptr, open(unary(), operand_type::sub) };
+                }
+
+                fragment lhs{ primary() };
+
+                if (tokens.type == token_type::exp) {
+                    tokens.next();
+                    return join(std::move(lhs), operand_type::exp, unary());
+                }
+
+                return lhs;
+            }
+            /* precedence climbing over the left associative operators */
+            fragment expression(int min_precedence) {
+                fragment lhs{ unary() };
+
+                for (;;) {
+                    int prec{ precedence(tokens.type) };
+
+                    if (prec == 0 || prec < min_precedence)
+                        return lhs;
+
+                    operand_type operand{ to_operand(tokens.type) };
+                    tokens.next();
+
+                    lhs = join(std::move(lhs), operand, expression(prec + 1));
+                }
+            }
+        };
+
+
+
+    } /* end detail */
+
+
+
+    /*      Parses text such as "11145*(333+44)^5" into a problem whose terms are owned by the problem. The usual precedence applies: '^' is
+    /*  right associative and binds tightest, followed by the signs, then '*' and '/', then '+' and '-'. Throws parse_error on malformed
+    /*  input.
+    */
+    inline std::unique_ptr<problem> parse(std::string_view text, number_base* base) {
+        std::unique_ptr<problem> prob{ std::make_unique<problem>() };
+        detail::parser state{ text, base, prob.get() };
+
+        try {
+            detail::fragment frag{ state.expression(1) };
+
+            if (state.tokens.type != token_type::end)
+                throw parse_error{ "Unexpected '" + std::string{ state.tokens.lexeme } + "'", state.tokens.start };
+
+            prob->expression = state.open(std::move(frag), operand_type::unknown);
+        }
+        catch (...) {
+            for (operation* op : state.created)
+                delete op;
+
+            throw;
+        }
+
+        return prob;
+    }
+
+
+
+} /* end calc */
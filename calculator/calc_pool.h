@@ -0,0 +1,303 @@
+#pragma once
+
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+
+
+namespace calc {
+
+
+
+    constexpr std::size_t POOL_MIN_BYTES = 64;              /* the smallest size class                                  */
+    constexpr std::size_t POOL_CLASSES = 17;                /* powers of two from POOL_MIN_BYTES, up to 4 MiB           */
+    constexpr std::size_t POOL_THREAD_BYTES = 1 << 20;      /* storage a thread may keep cached per size class          */
+    constexpr std::size_t POOL_DEPOT_BYTES = 1 << 24;       /* storage the depot may hold per size class                */
+    constexpr std::size_t POOL_FLUSH_EVENTS = 256;          /* thread statistics are published at least this often      */
+
+
+
+    /*  allocations:          Requests served by the pool.
+    /*  thread_hits:          Requests served from the calling thread's own cache.
+    /*  depot_hits:           Requests served after refilling the thread's cache from the shared depot.
+    /*  system_allocations:   Requests which had to go to the global allocator.
+    /*  system_frees:         Blocks handed back to the global allocator because every cache was full.
+    /*  depot_bytes:          Bytes currently parked in the shared depot.
+    /*  pooled_bytes:         Bytes currently resting in the depot and every thread's cache, counted only while the pool is tracked;
+    /*                        see track_pool.
+    /*
+    /*      Threads count their own events and publish them every POOL_FLUSH_EVENTS events and when they exit, so the totals lag behind
+    /*  by at most that many events per running thread.
+    */
+    struct pool_statistics {
+        std::atomic<std::uint64_t> allocations{};
+        std::atomic<std::uint64_t> thread_hits{};
+        std::atomic<std::uint64_t> depot_hits{};
+        std::atomic<std::uint64_t> system_allocations{};
+        std::atomic<std::uint64_t> system_frees{};
+        std::atomic<std::uint64_t> depot_bytes{};
+        std::atomic<std::int64_t> pooled_bytes{};
+    };
+
+
+
+    namespace detail {
+
+
+
+        /*      The shared half of the pool. Threads park surplus blocks here and refill from here before falling back on the global
+        /*  allocator, a size class at a time under that class's lock. It is never destroyed, so threads which outlive static destruction
+        /*  can still return their caches.
+        */
+        struct pool_depot {
+            struct size_class {
+                std::mutex lock{};
+                std::vector<void*> blocks{};
+            };
+
+            std::array<size_class, POOL_CLASSES> classes{};
+            pool_statistics statistics{};
+
+            /* set while a memory budget needs to see the storage held by the pool */
+            std::atomic<bool> tracked{};
+        };
+        inline pool_depot& depot() {
+            static pool_depot* shared{ new pool_depot{} };
+            return *shared;
+        }
+
+
+
+        constexpr std::size_t class_bytes(std::size_t size_class) {
+            return POOL_MIN_BYTES << size_class;
+        }
+        /* the size class serving bytes, POOL_CLASSES when it is too large to pool */
+        constexpr std::size_t class_of(std::size_t bytes) {
+            if (bytes <= POOL_MIN_BYTES)
+                return 0;
+
+            return std::min<std::size_t>(std::bit_width(bytes - 1) - std::bit_width(POOL_MIN_BYTES - 1), POOL_CLASSES);
+        }
+        /* blocks of a class a thread keeps before parking half of them in the depot */
+        constexpr std::size_t class_capacity(std::size_t size_class) {
+            return std::max<std::size_t>(POOL_THREAD_BYTES / class_bytes(size_class), 4);
+        }
+        constexpr std::size_t depot_capacity(std::size_t size_class) {
+            return std::max<std::size_t>(POOL_DEPOT_BYTES / class_bytes(size_class), 16);
+        }
+        /* the bytes an allocation of bytes really takes up, its whole size class when it is pooled */
+        constexpr std::size_t pool_footprint(std::size_t bytes) {
+            return class_of(bytes) == POOL_CLASSES ? bytes : class_bytes(class_of(bytes));
+        }
+
+        /* adds count blocks of a class to the pooled bytes, or takes them away, while the pool is tracked */
+        inline void count_pooled(std::size_t size_class, std::int64_t count) {
+            if (depot().tracked.load(std::memory_order_relaxed))
+                depot().statistics.pooled_bytes.fetch_add(count * static_cast<std::int64_t>(class_bytes(size_class)), std::memory_order_relaxed);
+        }
+
+
+
+        /*      Set once the calling thread's cache has been destroyed. Storage released later, by statics destroyed after the thread's
+        /*  locals, goes straight to the global allocator; the flag has no destructor of its own and stays readable until the thread is gone.
+        */
+        inline thread_local bool pool_torn_down{};
+
+
+
+        /* the per thread half of the pool; caches blocks without locking and counts events until they are published */
+        struct pool_cache {
+            std::array<std::vector<void*>, POOL_CLASSES> classes{};
+
+            std::uint64_t allocations{};
+            std::uint64_t thread_hits{};
+            std::uint64_t depot_hits{};
+            std::uint64_t system_allocations{};
+            std::uint64_t system_frees{};
+            std::uint64_t events{};
+
+
+            ~pool_cache() {
+                for (std::size_t size_class{}; size_class < POOL_CLASSES; size_class++)
+                    park(size_class, classes[size_class].size());
+
+                publish();
+                pool_torn_down = true;
+            }
+
+            void publish() {
+                pool_statistics& statistics{ depot().statistics };
+
+                statistics.allocations.fetch_add(allocations, std::memory_order_relaxed);
+                statistics.thread_hits.fetch_add(thread_hits, std::memory_order_relaxed);
+                statistics.depot_hits.fetch_add(depot_hits, std::memory_order_relaxed);
+                statistics.system_allocations.fetch_add(system_allocations, std::memory_order_relaxed);
+                statistics.system_frees.fetch_add(system_frees, std::memory_order_relaxed);
+
+                allocations = thread_hits = depot_hits = system_allocations = system_frees = events = 0;
+            }
+            void count() {
+                if (++events >= POOL_FLUSH_EVENTS)
+                    publish();
+            }
+
+            /* moves the most recently cached count blocks of a class to the depot, what the depot has no room for is freed */
+            void park(std::size_t size_class, std::size_t count) {
+                std::vector<void*>& cached{ classes[size_class] };
+                pool_depot::size_class& shared{ depot().classes[size_class] };
+
+                std::size_t parked{};
+                {
+                    std::lock_guard<std::mutex> lock{ shared.lock };
+                    parked = std::min(count, depot_capacity(size_class) - std::min(shared.blocks.size(), depot_capacity(size_class)));
+
+                    shared.blocks.insert(shared.blocks.end(), cached.end() - parked, cached.end());
+                    cached.resize(cached.size() - parked);
+                }
+
+                for (std::size_t ind{ parked }; ind < count; ind++) {
+                    ::operator delete(cached.back());
+                    cached.pop_back();
+                    system_frees++;
+                }
+
+                count_pooled(size_class, -static_cast<std::int64_t>(count - parked));
+
+                depot().statistics.depot_bytes.fetch_add(parked * class_bytes(size_class), std::memory_order_relaxed);
+            }
+            /* takes up to half a cache's worth of blocks of a class from the depot */
+            bool refill(std::size_t size_class) {
+                std::vector<void*>& cached{ classes[size_class] };
+                pool_depot::size_class& shared{ depot().classes[size_class] };
+
+                std::lock_guard<std::mutex> lock{ shared.lock };
+                std::size_t count{ std::min(shared.blocks.size(), class_capacity(size_class) / 2) };
+
+                cached.insert(cached.end(), shared.blocks.end() - count, shared.blocks.end());
+                shared.blocks.resize(shared.blocks.size() - count);
+
+                depot().statistics.depot_bytes.fetch_sub(count * class_bytes(size_class), std::memory_order_relaxed);
+
+                return count != 0;
+            }
+        };
+        inline thread_local pool_cache local_pool{};
+
+
+
+        inline void* pool_allocate(std::size_t bytes) {
+            std::size_t size_class{ class_of(bytes) };
+
+            if (size_class == POOL_CLASSES || pool_torn_down)
+                return ::operator new(bytes);
+
+            pool_cache& cache{ local_pool };
+            std::vector<void*>& cached{ cache.classes[size_class] };
+
+            cache.allocations++;
+
+            if (!cached.empty())
+                cache.thread_hits++;
+            else if (cache.refill(size_class))
+                cache.depot_hits++;
+            else {
+                cache.system_allocations++;
+                cache.count();
+
+                return ::operator new(class_bytes(size_class));
+            }
+
+            void* storage{ cached.back() };
+            cached.pop_back();
+
+            count_pooled(size_class, -1);
+
+            cache.count();
+            return storage;
+        }
+        inline void pool_free(void* storage, std::size_t bytes) {
+            std::size_t size_class{ class_of(bytes) };
+
+            if (size_class == POOL_CLASSES || pool_torn_down) {
+                ::operator delete(storage);
+                return;
+            }
+
+            pool_cache& cache{ local_pool };
+            std::vector<void*>& cached{ cache.classes[size_class] };
+
+            cached.push_back(storage);
+            count_pooled(size_class, 1);
+
+            if (cached.size() > class_capacity(size_class))
+                cache.park(size_class, cached.size() / 2);
+        }
+
+        /*      Hands the calling thread's cached blocks and every block in the depot back to the global allocator. Other threads' caches
+        /*  are left alone; they are bounded by POOL_THREAD_BYTES per class.
+        */
+        inline void pool_trim() {
+            if (!pool_torn_down) {
+                pool_cache& cache{ local_pool };
+
+                for (std::size_t size_class{}; size_class < POOL_CLASSES; size_class++) {
+                    for (void* storage : cache.classes[size_class])
+                        ::operator delete(storage);
+
+                    count_pooled(size_class, -static_cast<std::int64_t>(cache.classes[size_class].size()));
+                    cache.system_frees += cache.classes[size_class].size();
+                    cache.classes[size_class].clear();
+                }
+            }
+
+            for (std::size_t size_class{}; size_class < POOL_CLASSES; size_class++) {
+                pool_depot::size_class& shared{ depot().classes[size_class] };
+                std::lock_guard<std::mutex> lock{ shared.lock };
+
+                for (void* storage : shared.blocks)
+                    ::operator delete(storage);
+
+                count_pooled(size_class, -static_cast<std::int64_t>(shared.blocks.size()));
+                depot().statistics.depot_bytes.fetch_sub(shared.blocks.size() * class_bytes(size_class), std::memory_order_relaxed);
+                shared.blocks.clear();
+            }
+        }
+        /*      Starts or stops counting pooled_bytes. Blocks pooled while the count was off are not in it, so it is started with an empty
+        /*  depot and calling thread's cache, and never reads below zero.
+        */
+        inline void track_pool(bool tracked) {
+            pool_trim();
+            depot().statistics.pooled_bytes.store(0, std::memory_order_relaxed);
+            depot().tracked.store(tracked, std::memory_order_relaxed);
+        }
+        /* the bytes resting in the pool, zero while it is not tracked */
+        inline std::uint64_t pool_resident() {
+            std::int64_t pooled{ depot().statistics.pooled_bytes.load(std::memory_order_relaxed) };
+            return pooled > 0 ? static_cast<std::uint64_t>(pooled) : 0;
+        }
+
+
+
+    } /* end detail */
+
+
+
+    /* the pool's running totals, including the calling thread's unpublished events */
+    inline const pool_statistics& pool_stats() {
+        if (!detail::pool_torn_down)
+            detail::local_pool.publish();
+
+        return detail::depot().statistics;
+    }
+
+
+
+} /* end calc */
@@ -0,0 +1,161 @@
+#pragma once
+
+
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "calc_numbers.h"
+#include "calc_arithmetic.h"
+#include "calc_thread_pool.h"
+
+
+
+namespace calc {
+
+
+
+    constexpr std::size_t PARALLEL_REDUCE_LIMBS = 4096;  /* pairs with fewer limbs in total are combined on the calling thread */
+    constexpr std::size_t REBALANCE_MIN_TERMS = 4;       /* shorter chains of a problem are folded left to right as written     */
+
+
+
+    namespace detail {
+
+
+
+        /*      Reduces values with an associative operation as a balanced tree. Every level sorts the values by size and combines neighbours,
+        /*  so operands of similar size meet and the Karatsuba and squaring kernels see balanced inputs; a left-deep chain would instead
+        /*  multiply an ever growing value by small terms, quadratic in the length of the result. The pairs of a level are independent, the
+        /*  large ones go to the pool while the calling thread combines the small ones. Workers poll the caller's evaluation control.
+        */
+        template<typename Combine>
+        integer reduce_balanced(std::vector<integer> values, Combine combine, thread_pool* pool) {
+            evaluation_control* control{ active_control };
+
+            while (values.size() > 1) {
+                std::sort(values.begin(), values.end(), [](const integer& lhs, const integer& rhs) {
+                    return lhs.magnitude.size() < rhs.magnitude.size();
+                });
+
+                std::vector<integer> next((values.size() + 1) / 2);
+                std::vector<std::pair<std::size_t, std::future<integer>>> pending{};
+
+                try {
+                    for (std::size_t ind{}; ind + 1 < values.size(); ind += 2) {
+                        const integer& lhs{ values[ind] };
+                        const integer& rhs{ values[ind + 1] };
+
+                        if (lhs.magnitude.size() + rhs.magnitude.size() < PARALLEL_REDUCE_LIMBS) {
+                            next[ind / 2] = combine(lhs, rhs);
+                            continue;
+                        }
+
+                        if (pool == nullptr)
+                            pool = &shared_pool();
+
+                        if (pool->is_worker()) {
+                            next[ind / 2] = combine(lhs, rhs);
+                            continue;
+                        }
+
+                        pending.emplace_back(ind / 2, pool->submit([&lhs, &rhs, &combine, control]() {
+                            control_scope scope{ control };
+                            return combine(lhs, rhs);
+                        }));
+                    }
+
+                    for (auto& [ind, result] : pending)
+                        next[ind] = result.get();
+                }
+                catch (...) {
+                    /* the tasks still reference this level's values */
+                    for (auto& [ind, result] : pending) {
+                        if (result.valid())
+                            result.wait();
+                    }
+
+                    throw;
+                }
+
+                if (values.size() % 2)
+                    next.back() = std::move(values.back());
+
+                values = std::move(next);
+            }
+
+            return std::move(values.front());
+        }
+
+
+
+        /* rebases every value to the radix of the first */
+        inline std::vector<integer> common_radix(std::vector<integer> values) {
+            if (values.empty())
+                throw std::invalid_argument{ "Nothing to reduce" };
+
+            for (integer& value : values) {
+                if (!(value.rad == values.front().rad))
+                    value = rebase(value, values.front().rad);
+            }
+
+            return values;
+        }
+        inline std::vector<integer> load_all(const std::vector<const number*>& terms) {
+            if (terms.empty())
+                throw std::invalid_argument{ "Nothing to reduce" };
+
+            radix rad{ make_radix(terms.front()->base_size()) };
+            std::vector<integer> values{};
+            values.reserve(terms.size());
+
+            for (const number* term : terms)
+                values.push_back(rebase(load(*term), rad));
+
+            return values;
+        }
+
+
+
+    } /* end detail */
+
+
+
+    /*      The product and the sum of many values, formed as balanced trees; see detail::reduce_balanced. Results are in the radix of the
+    /*  first value. Large pairs are combined on the given pool, or on the shared pool when none is given.
+    */
+    inline integer product(std::vector<integer> values, thread_pool* pool = nullptr) {
+        return detail::reduce_balanced(detail::common_radix(std::move(values)), [](const integer& lhs, const integer& rhs) {
+            return multiply(lhs, rhs);
+        }, pool);
+    }
+    inline integer sum(std::vector<integer> values, thread_pool* pool = nullptr) {
+        return detail::reduce_balanced(detail::common_radix(std::move(values)), [](const integer& lhs, const integer& rhs) {
+            return add(lhs, rhs);
+        }, pool);
+    }
+
+
+
+    /* the same on numbers, the result is written in the base of the first term */
+    inline std::unique_ptr<number> product(const std::vector<const number*>& terms, thread_pool* pool = nullptr) {
+        std::unique_ptr<number> result{ std::make_unique<number>(terms.empty() ? nullptr : terms.front()->base) };
+        store(*result, product(detail::load_all(terms), pool));
+
+        return result;
+    }
+    inline std::unique_ptr<number> sum(const std::vector<const number*>& terms, thread_pool* pool = nullptr) {
+        std::unique_ptr<number> result{ std::make_unique<number>(terms.empty() ? nullptr : terms.front()->base) };
+        store(*result, sum(detail::load_all(terms), pool));
+
+        return result;
+    }
+
+
+
+} /* end calc */
@@ -0,0 +1,207 @@
+#pragma once
+
+
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "calc_numbers.h"
+#include "calc_arithmetic.h"
+
+
+
+namespace calc {
+
+
+
+    namespace detail {
+
+
+
+        /* x^k <= v, without overflowing */
+        inline bool power_at_most(std::uint64_t x, std::uint64_t k, std::uint64_t v) {
+            if (x < 2)
+                return x <= v;
+
+            std::uint64_t p{ 1 };
+
+            for (std::uint64_t ind{}; ind < k; ind++) {
+                if (p > v / x)
+                    return false;
+
+                p *= x;
+            }
+
+            return true;
+        }
+        /* floor(v^(1/k)) of a single word, from a floating point estimate which is then corrected */
+        inline std::uint64_t root_u64(std::uint64_t v, std::uint64_t k) {
+            if (v < 2 || k == 1)
+                return v;
+
+            if (k >= 64)
+                return 1;
+
+            std::uint64_t x{ static_cast<std::uint64_t>(std::pow(static_cast<double>(v), 1.0 / static_cast<double>(k))) };
+
+            while (x > 0 && !power_at_most(x, k, v))
+                x--;
+
+            while (power_at_most(x + 1, k, v))
+                x++;
+
+            return x;
+        }
+
+
+
+        /* x' = ((k - 1) x + n / x^(k - 1)) / k */
+        inline integer newton_root_step(const integer& n, const integer& x, std::uint64_t k) {
+            integer quotient{ divide(n, k == 2 ? x : power(x, k - 1)) };
+            integer sum{ add(multiply(from_uint64(k - 1, n.rad), x), quotient) };
+
+            return divide(sum, from_uint64(k, n.rad));
+        }
+
+
+
+        /*      floor(n^(1/k)) for n >= 0 with precision doubling. The root of n has about size / k limbs. Dropping the low k * h limbs of n,
+        /*  h = size / 2k, leaves a number whose root is the leading half of the wanted root; it is found recursively and (r0 + 1) * B^h is an
+        /*  overestimate correct to about half the limbs. One Newton step from there is enough to be correct to all but the last few units, and
+        /*  as Newton's method approaches the root from above every further step only decreases the estimate. A step is accepted as soon as
+        /*  its k-th power is at most n; that power is the one needed for the remainder anyway.
+        /*
+        /*  The recursion halves the size at every level, so the total cost is a small multiple of the final division and power.
+        */
+        inline integer root_floor(const integer& n, std::uint64_t k, integer* remainder) {
+            const radix& rad{ n.rad };
+
+            /* any value of at most two limbs fits a single word */
+            if (n.magnitude.size() <= 2) {
+                integer root{ from_uint64(root_u64(to_uint64(n), k), rad) };
+
+                if (remainder)
+                    *remainder = subtract(n, power(root, k));
+
+                return root;
+            }
+
+            std::size_t h{ n.magnitude.size() / (2 * k) };
+
+            if (h == 0) {
+                /* once k reaches the bit length of n, 2^k > n and the root is 1; a limb holds fewer than 32 bits */
+                if (k >= 32 * n.magnitude.size() || compare(n.magnitude, power(from_uint64(2, rad), k).magnitude) < 0) {
+                    if (remainder)
+                        *remainder = subtract(n, integer{ { 1 }, false, rad });
+
+                    return integer{ { 1 }, false, rad };
+                }
+
+                /* the root is below B^2, search it within a single word */
+                double log2n{ std::log2(static_cast<double>(n.magnitude.back())) + static_cast<double>(n.magnitude.size() - 1) * std::log2(static_cast<double>(rad.limb_base)) };
+                std::uint64_t bits{ static_cast<std::uint64_t>(log2n / static_cast<double>(k)) + 2 };
+
+                std::uint64_t lo{};
+                std::uint64_t hi{ bits >= 64 ? std::numeric_limits<std::uint64_t>::max() : std::uint64_t{ 1 } << bits };
+
+                while (lo < hi) {
+                    std::uint64_t mid{ lo + (hi - lo) / 2 + 1 };
+
+                    if (compare(power(from_uint64(mid, rad), k).magnitude, n.magnitude) <= 0)
+                        lo = mid;
+                    else
+                        hi = mid - 1;
+                }
+
+                integer root{ from_uint64(lo, rad) };
+
+                if (remainder)
+                    *remainder = subtract(n, power(root, k));
+
+                return root;
+            }
+
+            integer top{ limb_vector(n.magnitude.begin() + k * h, n.magnitude.end()), false, rad };
+            integer estimate{ add(root_floor(top, k, nullptr), integer{ { 1 }, false, rad }) };
+
+            integer x{ limb_vector(h, 0), false, rad };
+            x.magnitude.insert(x.magnitude.end(), estimate.magnitude.begin(), estimate.magnitude.end());
+
+            for (;;) {
+                x = newton_root_step(n, x, k);
+
+                integer p{ power(x, k) };
+
+                if (compare(p.magnitude, n.magnitude) <= 0) {
+                    if (remainder)
+                        *remainder = subtract(n, p);
+
+                    return x;
+                }
+
+                checkpoint(n.magnitude.size());
+            }
+        }
+
+
+
+    } /* end detail */
+
+
+
+    /*      The k-th root of value truncated towards zero, and value - root^k as the remainder. Odd roots of negative values are negative
+    /*  with a remainder of the same sign as the value; even roots of negative values throw.
+    */
+    inline void rootrem(const integer& value, std::uint64_t k, integer& root, integer& remainder) {
+        if (k == 0)
+            throw std::domain_error{ "Zeroth root" };
+
+        if (value.negative && k % 2 == 0)
+            throw std::domain_error{ "Even root of a negative number" };
+
+        integer magnitude{ value };
+        magnitude.negative = false;
+
+        root = detail::root_floor(magnitude, k, &remainder);
+
+        if (value.negative) {
+            root.negative = !root.is_zero();
+            remainder.negative = !remainder.is_zero();
+        }
+    }
+    inline integer iroot(const integer& value, std::uint64_t k) {
+        integer root{};
+        integer remainder{};
+
+        rootrem(value, k, root, remainder);
+
+        return root;
+    }
+    inline void sqrtrem(const integer& value, integer& root, integer& remainder) {
+        rootrem(value, 2, root, remainder);
+    }
+    inline integer isqrt(const integer& value) {
+        return iroot(value, 2);
+    }
+
+
+
+    /* the same on numbers, the root and remainder are written in the bases of the numbers receiving them */
+    inline void rootrem(const number& value, std::uint64_t k, number& root, number& remainder) {
+        integer r{};
+        integer rem{};
+
+        rootrem(load(value), k, r, rem);
+
+        store(root, r);
+        store(remainder, rem);
+    }
+    inline void sqrtrem(const number& value, number& root, number& remainder) {
+        rootrem(value, 2, root, remainder);
+    }
+
+
+
+} /* end calc */
@@ -0,0 +1,181 @@
+#pragma once
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <string>
+
+#include "calc_mapped_file.h"
+#include "calc_pool.h"
+
+
+
+namespace calc {
+
+
+
+    constexpr std::uint64_t SPILL_MIN_BYTES = 1 << 20; /* allocations below this always stay on the heap, even over budget */
+
+
+
+    /*  limit:        Bytes of digit and limb storage allowed on the heap, unlimited by default.
+    /*  in_use:       Bytes currently charged against the limit.
+    /*  spilled:      Bytes currently held in spill files.
+    /*  spill_count:  Spill files created so far.
+    /*  directory:    Where spill files are created, empty for the system's temporary directory.
+    /*
+    /*      Storage allocated while the budget is unlimited is never charged to it, so the budget is best set before any numbers are made.
+    /*  The directory is read without synchronisation and must not change while numbers are being allocated.
+    /*
+    /*      Freed storage goes back to the pool, see calc_pool.h, and is no longer charged; while the budget is limited the pool counts the
+    /*  bytes it holds and they are charged alongside in_use. When they stand in the way of an allocation the pool is trimmed first.
+    */
+    struct storage_budget {
+        std::atomic<std::uint64_t> limit{ std::numeric_limits<std::uint64_t>::max() };
+        std::atomic<std::uint64_t> in_use{};
+        std::atomic<std::uint64_t> spilled{};
+        std::atomic<std::uint64_t> spill_count{};
+        std::string directory{};
+
+
+        bool limited() const {
+            return limit.load(std::memory_order_relaxed) != std::numeric_limits<std::uint64_t>::max();
+        }
+        std::uint64_t available() const {
+            std::uint64_t cap{ limit.load(std::memory_order_relaxed) };
+            std::uint64_t used{ in_use.load(std::memory_order_relaxed) + detail::pool_resident() };
+
+            return used < cap ? cap - used : 0;
+        }
+
+        /*      Charges bytes to the budget. Returns false when they do not fit and are large enough to be worth a spill file; reserved
+        /*  receives what has to be handed back to release once the storage is freed.
+        */
+        bool admit(std::uint64_t bytes, std::uint64_t& reserved) {
+            reserved = 0;
+
+            if (!limited())
+                return true;
+
+            std::uint64_t used{ in_use.load(std::memory_order_relaxed) };
+            bool trimmed{};
+
+            for (;;) {
+                if (used + detail::pool_resident() + bytes > limit.load(std::memory_order_relaxed) && bytes >= SPILL_MIN_BYTES) {
+                    if (trimmed || detail::pool_resident() == 0)
+                        return false;
+
+                    detail::pool_trim();
+                    trimmed = true;
+                    used = in_use.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                if (in_use.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed))
+                    break;
+            }
+
+            reserved = bytes;
+            return true;
+        }
+        void release(std::uint64_t reserved) {
+            if (reserved)
+                in_use.fetch_sub(reserved, std::memory_order_relaxed);
+        }
+    };
+
+    inline storage_budget memory_budget{};
+
+    inline void set_memory_budget(std::uint64_t bytes, const std::string& directory = {}) {
+        memory_budget.directory = directory;
+        memory_budget.limit.store(bytes);
+
+        detail::track_pool(memory_budget.limited());
+    }
+
+
+
+    namespace detail {
+
+
+
+        inline spill_region* open_spill(std::uint64_t bytes) {
+            spill_region* region{ new spill_region(static_cast<std::size_t>(bytes), memory_budget.directory) };
+
+            memory_budget.spilled.fetch_add(bytes, std::memory_order_relaxed);
+            memory_budget.spill_count.fetch_add(1, std::memory_order_relaxed);
+
+            return region;
+        }
+        inline void close_spill(spill_region* region) {
+            memory_budget.spilled.fetch_sub(region->size, std::memory_order_relaxed);
+            delete region;
+        }
+
+
+
+        /* precedes every block handed out by spill_allocator; 16 bytes keeps the payload aligned for anything a limb vector holds */
+        struct alignas(16) spill_header {
+            spill_region* region{};
+            std::uint64_t reserved{};
+        };
+
+
+
+    } /* end detail */
+
+
+
+    /*      An allocator which charges the storage budget and takes its blocks from the storage pool, or, once the budget is exhausted,
+    /*  places large blocks in spill files instead. Containers using it are unaware of where their elements live; the operating system pages
+    /*  spilled elements in and out as they are touched, which is cheap as long as they are touched in order.
+    */
+    template<typename T>
+    struct spill_allocator {
+        using value_type = T;
+
+        spill_allocator() = default;
+        template<typename U>
+        spill_allocator(const spill_allocator<U>&) noexcept {}
+
+
+        T* allocate(std::size_t count) {
+            std::uint64_t bytes{ count * sizeof(T) + sizeof(detail::spill_header) };
+            std::uint64_t reserved{};
+            detail::spill_header* header{};
+
+            if (memory_budget.admit(detail::pool_footprint(static_cast<std::size_t>(bytes)), reserved)) {
+                header = static_cast<detail::spill_header*>(detail::pool_allocate(static_cast<std::size_t>(bytes)));
+                header->region = nullptr;
+            }
+            else {
+                spill_region* region{ detail::open_spill(bytes) };
+                header = static_cast<detail::spill_header*>(region->data);
+                header->region = region;
+            }
+
+            header->reserved = reserved;
+            return reinterpret_cast<T*>(header + 1);
+        }
+        void deallocate(T* data, std::size_t count) noexcept {
+            detail::spill_header* header{ reinterpret_cast<detail::spill_header*>(data) - 1 };
+
+            memory_budget.release(header->reserved);
+
+            if (header->region)
+                detail::close_spill(header->region);
+            else
+                detail::pool_free(header, count * sizeof(T) + sizeof(detail::spill_header));
+        }
+
+        friend bool operator==(const spill_allocator&, const spill_allocator&) {
+            return true;
+        }
+    };
+
+
+
+} /* end calc */
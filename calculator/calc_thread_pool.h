@@ -0,0 +1,119 @@
+#pragma once
+
+
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace calc {
+
+
+
+    /*  thread_pool: A fixed set of worker threads draining one shared queue of tasks. Work is handed in with submit, which returns a future
+    /*  for the task's result. Destroying the pool finishes every queued task before the workers are joined.
+    */
+    struct thread_pool {
+        std::vector<std::thread> workers{};
+        std::deque<std::function<void()>> tasks{};
+
+        std::mutex queue_lock{};
+        std::condition_variable queue_condition{};
+        bool stopping{};
+
+        /* the pool the calling thread works for, if any */
+        static inline thread_local thread_pool* current{};
+
+
+        explicit thread_pool(std::size_t thread_count = std::thread::hardware_concurrency()) {
+            if (thread_count == 0) thread_count = 1;
+
+            for (std::size_t ind{}; ind < thread_count; ind++)
+                workers.emplace_back([this]() { this->work(); });
+        }
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock{ queue_lock };
+                stopping = true;
+            }
+
+            queue_condition.notify_all();
+
+            for (std::thread& worker : workers)
+                worker.join();
+        }
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+
+
+        void work() {
+            current = this;
+
+            for (;;) {
+                std::function<void()> task{};
+
+                {
+                    std::unique_lock<std::mutex> lock{ queue_lock };
+                    queue_condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+                    if (tasks.empty())
+                        return;
+
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+
+                task();
+            }
+        }
+
+
+
+        template<typename F>
+        std::future<std::invoke_result_t<F>> submit(F&& func) {
+            /* std::function requires a copyable target, so the move-only packaged_task is shared */
+            auto task{ std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(func)) };
+            std::future<std::invoke_result_t<F>> result{ task->get_future() };
+
+            {
+                std::lock_guard<std::mutex> lock{ queue_lock };
+                tasks.emplace_back([task]() { (*task)(); });
+            }
+
+            queue_condition.notify_one();
+
+            return result;
+        }
+
+
+
+        std::size_t size() const {
+            return workers.size();
+        }
+        /* a task waiting on other tasks of its own pool could wait forever once every worker does the same */
+        bool is_worker() const {
+            return current == this;
+        }
+    };
+
+
+
+    /* one worker per hardware thread, started on first use and shared by everything which does not bring its own pool */
+    inline thread_pool& shared_pool() {
+        static thread_pool pool{};
+        return pool;
+    }
+
+
+
+} /* end calc */
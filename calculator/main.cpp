@@ -1,5 +1,10 @@
 ﻿#include "calc_numbers.h"
+#include "calc_evaluate.h"
+#include "calc_batch.h"
+#include "calc_mapped_file.h"
 
+#include <cstdio>
+#include <cstring>
 #include <vector>
 #include <io.h>      // For _setmode
 #include <fcntl.h>   // For _O_U16TEXT
@@ -16,7 +21,56 @@ calc::number_base base5{ "01234" };
 calc::number_base base10{ "0123456789" };
 calc::number_base base16{ "0123456789abcdef" };
 
-int main() {
+/*  calculator --batch [file] [--threads n] [--memory bytes] [--spill-dir path]
+/*
+/*  Evaluates one expression per line of the file, or of stdin when no file is given, and writes one result per line in input order.
+/*  Past the memory budget large numbers are kept in temporary files in the spill directory.
+*/
+int batch(int argc, char** argv) {
+	calc::batch_options options{ &base10 };
+	const char* path{};
+	std::uint64_t memory{};
+	std::string spill_dir{};
+
+	for (int ind{ 2 }; ind < argc; ind++) {
+		if (std::strcmp(argv[ind], "--threads") == 0 && ind + 1 < argc)
+			options.threads = std::strtoull(argv[++ind], nullptr, 10);
+		else if (std::strcmp(argv[ind], "--memory") == 0 && ind + 1 < argc)
+			memory = std::strtoull(argv[++ind], nullptr, 10);
+		else if (std::strcmp(argv[ind], "--spill-dir") == 0 && ind + 1 < argc)
+			spill_dir = argv[++ind];
+		else
+			path = argv[ind];
+	}
+
+	if (memory)
+		calc::set_memory_budget(memory, spill_dir);
+
+	_setmode(_fileno(stdout), _O_BINARY);
+	std::setvbuf(stdout, nullptr, _IOFBF, 1 << 20);
+
+	try {
+		if (path) {
+			calc::mapped_file file{ path };
+			calc::run_batch(std::string_view{ file.data, file.size }, stdout, options);
+		}
+		else {
+			_setmode(_fileno(stdin), _O_BINARY);
+			calc::run_batch(stdin, stdout, options);
+		}
+	}
+	catch (const std::exception& error) {
+		std::fprintf(stderr, "%s\n", error.what());
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1 && std::strcmp(argv[1], "--batch") == 0)
+		return batch(argc, argv);
+
 	if (!_setmode(_fileno(stdout), _O_U16TEXT)) {
 		return 1;
 	}
@@ -54,5 +108,9 @@ int main() {
 			std::wcout << "\n";
 	}
 
+	auto&& result{ calc::evaluate(prob) };
+
+	std::wcout << "\n\n" << *result << "\n";
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "../calc_numbers.h"
+#include "../calc_arithmetic.h"
+#include "../calc_accumulator.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+/*  Regression cases for calc_accumulator.h; returns nonzero when a case fails. Builds against the headers alone:
+/*
+/*      cl /std:c++20 /EHsc /O2 tests\accumulator_tests.cpp
+/*      g++ -std=c++20 -O2 tests/accumulator_tests.cpp
+*/
+
+calc::number_base base2{ "01" };
+calc::number_base base10{ "0123456789" };
+calc::number_base base16{ "0123456789abcdef" };
+
+/* 200 symbols, which leaves a digit field no room for a second term */
+std::string wide_symbols{ [] {
+	std::string symbols{};
+
+	for (int symbol{ 33 }; symbol < 233; symbol++)
+		symbols.push_back(static_cast<char>(symbol));
+
+	return symbols;
+}() };
+calc::number_base base200{ wide_symbols.c_str() };
+
+/* a number of the given digit count, from a fixed linear congruential sequence so that failures reproduce */
+std::string digits(std::size_t count, std::uint64_t& seed, calc::number_base* base) {
+	std::uint64_t symbols{ std::strlen(base->symbol_vec) };
+	std::string text{};
+
+	for (std::size_t ind{}; ind < count; ind++) {
+		seed = seed * 6364136223846793005 + 1442695040888963407;
+		text.push_back(base->symbol_vec[ind == 0 ? 1 + (seed >> 33) % (symbols - 1) : (seed >> 33) % symbols]);
+	}
+
+	return text;
+}
+
+/* the digits of a number as printed, without the digit group separators */
+std::wstring text(const calc::number& num) {
+	std::wostringstream out{};
+	out << num;
+
+	std::wstring digits{};
+
+	for (wchar_t symbol : out.str()) {
+		if (symbol != L',')
+			digits.push_back(symbol);
+	}
+
+	return digits;
+}
+
+bool equal(const calc::integer& lhs, const calc::integer& rhs) {
+	return lhs.negative == rhs.negative && calc::detail::compare(lhs.magnitude, rhs.magnitude) == 0;
+}
+
+int failures{};
+
+void check(bool passed, const char* name) {
+	if (!passed) {
+		std::printf("FAILED: %s\n", name);
+		failures++;
+	}
+}
+
+/*      Sums enough terms of varied lengths to normalize several times and compares the result with adding one term at a time. Every
+/*  third term is subtracted, so both banks fill and the sum changes sign along the way.
+*/
+void sums(calc::number_base* base, const char* name) {
+	std::uint64_t seed{ 3 };
+	calc::accumulator acc{ base };
+	calc::integer expected{ {}, false, acc.rad };
+
+	for (std::size_t ind{}; ind < 100; ind++) {
+		calc::number term{ base };
+		term.assign(digits(1 + (ind * 37) % 90, seed, base).c_str());
+
+		if (ind % 3 == 2) {
+			acc.subtract(term);
+			expected = calc::subtract(expected, calc::load(term));
+		}
+		else {
+			acc.add(term);
+			expected = calc::add(expected, calc::load(term));
+		}
+
+		if (ind % 10 == 9)
+			check(equal(acc.value(), expected), name);
+	}
+
+	acc.clear();
+	check(acc.value().is_zero(), "a cleared accumulator is zero");
+}
+
+/* a field of nines in every position carries through the whole sum */
+void carries() {
+	calc::accumulator acc{ &base10 };
+	calc::number nines{ &base10 };
+	nines.assign(std::string(100, '9').c_str());
+
+	for (int ind{}; ind < 1000; ind++)
+		acc.add(nines);
+
+	calc::number sum{ &base10 };
+	acc.store(sum);
+
+	check(text(sum) == std::wstring(100, L'9') + L"000", "1000 times 10^100 - 1");
+}
+
+/* terms in other bases are re-expressed in the accumulator's base, including bases which share its limb base */
+void mixed_bases() {
+	calc::accumulator acc{ &base16 };
+	calc::number eleven{ &base2 };
+	eleven.assign("1011");
+
+	acc.add(eleven);
+
+	std::wostringstream out{};
+	out << acc;
+	check(out.str() == L"b", "a base2 term printed in base16");
+
+	calc::number ten{ &base10 };
+	ten.assign("10");
+
+	acc.add(ten);
+	acc.subtract(calc::from_uint64(5, calc::make_radix(10)));
+	check(calc::to_uint64(acc.value()) == 16, "base2, base10 and integer terms");
+
+	calc::number sixteen{ &base10 };
+	sixteen.assign("16");
+	calc::number seventeen{ &base2 };
+	seventeen.assign("10001");
+
+	check(acc.compare(sixteen) == 0, "compares equal to a base10 number");
+	check(acc.compare(seventeen) < 0, "compares below a base2 number");
+
+	calc::number negative{ &base10 };
+	negative.assign("100");
+	negative.negative = true;
+	check(acc.compare(negative) > 0, "compares above a negative number");
+
+	acc.add(negative);
+	check(acc.compare(negative) > 0 && acc.compare(sixteen) < 0, "a negative sum compares by sign");
+}
+
+int main() {
+	sums(&base10, "decimal sums");
+	sums(&base2, "binary sums");
+	sums(&base16, "hexadecimal sums");
+	sums(&base200, "sums without headroom");
+	carries();
+	mixed_bases();
+
+	if (failures == 0)
+		std::printf("all accumulator cases passed\n");
+
+	return failures != 0;
+}
@@ -0,0 +1,134 @@
+#include "../calc_numbers.h"
+#include "../calc_evaluate.h"
+#include "../calc_cache.h"
+#include "../calc_parser.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+
+/*  Regression cases for calc_cache.h; returns nonzero when a case fails. Builds against the headers alone:
+/*
+/*      cl /std:c++20 /EHsc /O2 tests\cache_tests.cpp
+/*      g++ -std=c++20 -O2 -pthread tests/cache_tests.cpp
+*/
+
+calc::number_base base2{ "01" };
+calc::number_base base10{ "0123456789" };
+calc::number_base base16{ "0123456789abcdef" };
+
+/* the digits of a number as printed, without the digit group separators */
+std::wstring text(const calc::number& num) {
+	std::wostringstream out{};
+	out << num;
+
+	std::wstring digits{};
+
+	for (wchar_t symbol : out.str()) {
+		if (symbol != L',')
+			digits.push_back(symbol);
+	}
+
+	return digits;
+}
+std::wstring result_of(calc::problem* prob) {
+	std::unique_ptr<calc::problem> owned{ prob };
+	return text(*calc::evaluate(prob));
+}
+
+int failures{};
+
+void check(bool passed, const char* name) {
+	if (!passed) {
+		std::printf("FAILED: %s\n", name);
+		failures++;
+	}
+}
+
+/*      Bases 2 and 16 share a limb base. A product cached while evaluating in base 16 must not be served to the same terms evaluated in
+/*  base 2, where the digits of its limbs are read differently.
+*/
+void mixed_bases() {
+	calc::evaluation_cache().clear();
+
+	calc::number a{ &base16 };
+	calc::number x{ &base16 };
+	calc::number b{ &base2 };
+
+	a.assign(("1" + std::string(600, '0')).c_str());
+	x.assign(("1" + std::string(600, '0')).c_str());
+	b.assign(("1" + std::string(4805, '0')).c_str());
+
+	check(result_of(a * x) == L"1" + std::wstring(1200, L'0'), "16^600 squared in base 16");
+	check(result_of(b / (a * x)) == L"100000", "a product cached in base 16 is not reused in base 2");
+	check(result_of(a * x) == L"1" + std::wstring(1200, L'0'), "a product cached in base 2 is not reused in base 16");
+}
+
+/* digits written through a number's blocks give it a new version, so results cached for the old digits are not served */
+void written_blocks() {
+	calc::evaluation_cache().clear();
+
+	calc::number x{ &base10 };
+	calc::number y{ &base10 };
+
+	x.assign(std::string(700, '7').c_str());
+	y.assign(std::string(700, '7').c_str());
+
+	std::wstring before{ result_of(x * y) };
+
+	std::uint64_t fields{ 8 };
+	x[0]->set_fields(fields);
+
+	std::wstring after{ result_of(x * y) };
+
+	calc::evaluation_cache().clear();
+
+	check(after != before, "a written block changes the product");
+	check(after == result_of(x * y), "the product of the written digits matches an uncached evaluation");
+}
+
+/* an unchanged problem is served from the cache */
+void repeated_problem() {
+	calc::evaluation_cache().clear();
+
+	calc::number x{ &base10 };
+	calc::number y{ &base10 };
+
+	x.assign(std::string(700, '3').c_str());
+	y.assign(std::string(700, '9').c_str());
+
+	std::uint64_t hits{ calc::cache_stats().hits.load() };
+	std::wstring first{ result_of(x * y) };
+
+	check(result_of(x * y) == first, "a repeated product is unchanged");
+	check(calc::cache_stats().hits.load() > hits, "a repeated product hits the cache");
+}
+
+/* parsed problems own their literals, their steps can never be hit again and stay out of the shared cache */
+void parsed_problems() {
+	calc::evaluation_cache().clear();
+
+	std::string digits(700, '7');
+	std::string line{ "(" + digits + " * " + digits + ") - (" + digits + " * " + digits + ")" };
+
+	std::uint64_t insertions{ calc::cache_stats().insertions.load() };
+	std::unique_ptr<calc::problem> prob{ calc::parse(line, &base10) };
+	calc::integer value{ calc::evaluate_value(prob.get()) };
+
+	check(value.is_zero(), "a repeated product within a parsed line");
+	check(calc::cache_stats().insertions.load() == insertions, "a parsed line leaves the shared cache alone");
+}
+
+int main() {
+	mixed_bases();
+	written_blocks();
+	repeated_problem();
+	parsed_problems();
+
+	if (failures == 0)
+		std::printf("all cache cases passed\n");
+
+	return failures != 0;
+}
@@ -0,0 +1,82 @@
+#include "../calc_numbers.h"
+#include "../calc_arithmetic.h"
+#include "../calc_gcd.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/*  Regression cases for calc_gcd.h; returns nonzero when a case fails. Builds against the headers alone:
+/*
+/*      cl /std:c++20 /EHsc /O2 tests\gcd_tests.cpp
+/*      g++ -std=c++20 -O2 tests/gcd_tests.cpp
+*/
+
+calc::number_base base10{ "0123456789" };
+
+/* a number of the given digit count, from a fixed linear congruential sequence so that failures reproduce */
+calc::integer digits(std::size_t count, std::uint64_t& seed) {
+	std::string text{};
+
+	for (std::size_t ind{}; ind < count; ind++) {
+		seed = seed * 6364136223846793005 + 1442695040888963407;
+		text.push_back(static_cast<char>('0' + (ind == 0 ? 1 + (seed >> 33) % 9 : (seed >> 33) % 10)));
+	}
+
+	calc::number num{ &base10 };
+	num.assign(text.c_str());
+
+	return calc::load(num);
+}
+
+bool equal(const calc::integer& lhs, const calc::integer& rhs) {
+	return lhs.negative == rhs.negative && calc::detail::compare(lhs.magnitude, rhs.magnitude) == 0;
+}
+
+int failures{};
+
+void check(bool passed, const char* name, std::size_t size) {
+	if (!passed) {
+		std::printf("FAILED: %s, %zu digits\n", name, size);
+		failures++;
+	}
+}
+
+/*      gcd(c x, c y) with a large common factor c: half-gcd can reduce b to zero without shrinking a, which used to fall through to a
+/*  division by zero.
+*/
+void common_factor(std::size_t size, std::uint64_t seed) {
+	calc::integer c{ digits(size, seed) };
+	calc::integer a{ calc::multiply(c, digits(size, seed)) };
+	calc::integer b{ calc::multiply(c, digits(size, seed)) };
+
+	calc::integer g{ calc::gcd(a, b) };
+	calc::integer q{};
+	calc::integer r{};
+
+	calc::divide(g, c, q, r);
+	check(r.is_zero(), "gcd divisible by the common factor", size);
+
+	calc::integer one{ calc::gcd(calc::divide(a, g), calc::divide(b, g)) };
+	check(one.magnitude.size() == 1 && one.magnitude[0] == 1, "cofactors of the gcd coprime", size);
+
+	calc::integer h{};
+	calc::integer s{};
+	calc::integer t{};
+
+	calc::gcdext(a, b, h, s, t);
+	check(equal(h, g), "gcdext agrees with gcd", size);
+	check(equal(calc::add(calc::multiply(s, a), calc::multiply(t, b)), h), "gcdext Bezout identity", size);
+}
+
+int main() {
+	for (std::size_t size : { 10, 300, 1000, 3000 }) {
+		for (std::uint64_t seed{ 1 }; seed <= 5; seed++)
+			common_factor(size, seed);
+	}
+
+	if (failures == 0)
+		std::printf("all gcd cases passed\n");
+
+	return failures != 0;
+}
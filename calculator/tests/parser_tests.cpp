@@ -0,0 +1,122 @@
+#include "../calc_numbers.h"
+#include "../calc_evaluate.h"
+#include "../calc_parser.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+/*  Regression cases for calc_parser.h; returns nonzero when a case fails. Builds against the headers alone:
+/*
+/*      cl /std:c++20 /EHsc /O2 tests\parser_tests.cpp
+/*      g++ -std=c++20 -O2 -pthread tests/parser_tests.cpp
+*/
+
+calc::number_base base10{ "0123456789" };
+calc::number_base base16{ "0123456789abcdef" };
+
+int failures{};
+
+void check(bool passed, const char* name) {
+	if (!passed) {
+		std::printf("FAILED: %s\n", name);
+		failures++;
+	}
+}
+
+/* the value of text parsed in a base, which must fit a signed 64 bit word */
+std::int64_t value_of(const std::string& text, calc::number_base* base = &base10) {
+	std::unique_ptr<calc::problem> prob{ calc::parse(text, base) };
+	calc::integer value{ calc::evaluate_value(prob.get()) };
+
+	std::int64_t magnitude{ static_cast<std::int64_t>(calc::to_uint64(value)) };
+
+	return value.negative ? -magnitude : magnitude;
+}
+
+/* true when parsing text throws parse_error */
+bool rejects(const std::string& text) {
+	try {
+		calc::parse(text, &base10);
+	}
+	catch (const calc::parse_error&) {
+		return true;
+	}
+
+	return false;
+}
+
+/* '*' and '/' bind tighter than '+' and '-', parentheses override both */
+void precedence() {
+	check(value_of("2+3*4") == 14, "2+3*4");
+	check(value_of("2*3+4") == 10, "2*3+4");
+	check(value_of("(2+3)*4") == 20, "(2+3)*4");
+	check(value_of("2*(3+4)") == 14, "2*(3+4)");
+	check(value_of("1+2+3*4^2") == 51, "1+2+3*4^2");
+	check(value_of("2*3^2") == 18, "2*3^2");
+	check(value_of("((7))") == 7, "((7))");
+	check(value_of(" 6 *\t7 ") == 42, "whitespace separates tokens");
+}
+
+/* '+', '-', '*' and '/' group to the left, '^' to the right */
+void associativity() {
+	check(value_of("100-10-1") == 89, "100-10-1");
+	check(value_of("100/10/2") == 5, "100/10/2");
+	check(value_of("7-(2-3)") == 8, "7-(2-3)");
+	check(value_of("64/(8/2)") == 16, "64/(8/2)");
+	check(value_of("10-2*3-1") == 3, "10-2*3-1");
+	check(value_of("2^3^2") == 512, "2^3^2");
+	check(value_of("(2^3)^2") == 64, "(2^3)^2");
+}
+
+/* a leading sign binds looser than '^' and tighter than the binary operators */
+void signs() {
+	check(value_of("-2^2") == -4, "-2^2");
+	check(value_of("(-2)^2") == 4, "(-2)^2");
+	check(value_of("-2*3") == -6, "-2*3");
+	check(value_of("2*-3") == -6, "2*-3");
+	check(value_of("3--2") == 5, "3--2");
+	check(value_of("--5") == 5, "--5");
+	check(value_of("+5-+2") == 3, "+5-+2");
+	check(value_of("2-5") == -3, "2-5");
+}
+
+/* letters are numerals in base16 */
+void other_bases() {
+	check(value_of("ff+1", &base16) == 256, "ff+1 in base16");
+	check(value_of("a*(b+c)", &base16) == 230, "a*(b+c) in base16");
+}
+
+/* a numeral spelled twice is parsed into a single term */
+void shared_numerals() {
+	std::unique_ptr<calc::problem> prob{ calc::parse("12*12+12-7", &base10) };
+
+	check(prob->literals.size() == 2, "a repeated numeral is one term");
+	check(calc::to_uint64(calc::evaluate_value(prob.get())) == 149, "12*12+12-7");
+}
+
+void malformed() {
+	check(rejects(""), "an empty expression");
+	check(rejects("2+"), "a missing operand");
+	check(rejects("(2+3"), "an unclosed parenthesis");
+	check(rejects("2+3)"), "an unopened parenthesis");
+	check(rejects("2 3"), "two numerals in a row");
+	check(rejects("2*a"), "a letter in base10");
+	check(rejects("*2"), "a leading binary operator");
+	check(rejects("()"), "empty parentheses");
+}
+
+int main() {
+	precedence();
+	associativity();
+	signs();
+	other_bases();
+	shared_numerals();
+	malformed();
+
+	if (failures == 0)
+		std::printf("all parser cases passed\n");
+
+	return failures != 0;
+}
@@ -0,0 +1,88 @@
+#include "../calc_numbers.h"
+#include "../calc_arithmetic.h"
+#include "../calc_storage.h"
+#include "../calc_pool.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*  Regression cases for calc_pool.h and calc_storage.h; returns nonzero when a case fails. Builds against the headers alone:
+/*
+/*      cl /std:c++20 /EHsc /O2 tests\pool_tests.cpp
+/*      g++ -std=c++20 -O2 -pthread tests/pool_tests.cpp
+*/
+
+calc::number_base base10{ "0123456789" };
+
+/* assigned more than once and destroyed after the main thread's pool, whose storage must then go straight back to the system */
+calc::number reassigned{ &base10 };
+
+int failures{};
+
+void check(bool passed, const char* name) {
+	if (!passed) {
+		std::printf("FAILED: %s\n", name);
+		failures++;
+	}
+}
+
+/* storage resting in the pool is charged to a limited budget, and is trimmed when it stands in the way of an allocation */
+void pooled_storage_is_charged() {
+	constexpr std::uint64_t mib{ 1 << 20 };
+
+	calc::set_memory_budget(16 * mib);
+
+	std::uint64_t spills{ calc::memory_budget.spill_count.load() };
+
+	{
+		/* 1.5 MiB each, a 2 MiB size class */
+		std::vector<calc::limb_vector> vectors(6);
+
+		for (calc::limb_vector& vector : vectors)
+			vector.resize(3 * mib / 2 / sizeof(calc::limb));
+
+		check(calc::memory_budget.in_use.load() >= 12 * mib, "live vectors are charged their size class");
+	}
+
+	check(calc::memory_budget.in_use.load() + calc::detail::pool_resident() >= 12 * mib, "freed vectors stay charged while pooled");
+	check(calc::memory_budget.in_use.load() + calc::detail::pool_resident() <= 16 * mib, "charges stay within the budget");
+
+	{
+		/* too large to pool, and only fits once the pool is trimmed */
+		calc::limb_vector large(8 * mib / sizeof(calc::limb));
+
+		check(calc::memory_budget.spill_count.load() == spills, "the pool is trimmed before spilling");
+		check(calc::memory_budget.in_use.load() + calc::detail::pool_resident() <= 16 * mib, "charges stay within the budget after a trim");
+	}
+
+	calc::set_memory_budget(std::numeric_limits<std::uint64_t>::max());
+}
+
+/* a pooled block comes back for the next allocation of its size class */
+void blocks_are_reused() {
+	std::uint64_t hits{ calc::pool_stats().thread_hits.load() };
+
+	for (int round{}; round < 4; round++) {
+		calc::number num{ &base10 };
+		num.assign(std::string(1000, '9').c_str());
+	}
+
+	check(calc::pool_stats().thread_hits.load() >= hits + 3, "freed blocks are reused by the same thread");
+}
+
+int main() {
+	reassigned.assign(std::string(1000, '1').c_str());
+	reassigned.assign(std::string(1001, '2').c_str());
+
+	pooled_storage_is_charged();
+	blocks_are_reused();
+
+	if (failures == 0)
+		std::printf("all pool cases passed\n");
+
+	return failures != 0;
+}
@@ -0,0 +1,178 @@
+#include "../calc_numbers.h"
+#include "../calc_arithmetic.h"
+#include "../calc_roots.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/*  Regression cases for calc_roots.h; returns nonzero when a case fails. Builds against the headers alone:
+/*
+/*      cl /std:c++20 /EHsc /O2 tests\roots_tests.cpp
+/*      g++ -std=c++20 -O2 tests/roots_tests.cpp
+*/
+
+calc::number_base base2{ "01" };
+calc::number_base base10{ "0123456789" };
+calc::number_base base16{ "0123456789abcdef" };
+
+/* a number of the given digit count, from a fixed linear congruential sequence so that failures reproduce */
+calc::integer digits(std::size_t count, std::uint64_t& seed, calc::number_base* base = &base10) {
+	std::uint64_t symbols{ std::strlen(base->symbol_vec) };
+	std::string text{};
+
+	for (std::size_t ind{}; ind < count; ind++) {
+		seed = seed * 6364136223846793005 + 1442695040888963407;
+		text.push_back(base->symbol_vec[ind == 0 ? 1 + (seed >> 33) % (symbols - 1) : (seed >> 33) % symbols]);
+	}
+
+	calc::number num{ base };
+	num.assign(text.c_str());
+
+	return calc::load(num);
+}
+
+bool equal(const calc::integer& lhs, const calc::integer& rhs) {
+	return lhs.negative == rhs.negative && calc::detail::compare(lhs.magnitude, rhs.magnitude) == 0;
+}
+
+int failures{};
+
+void check(bool passed, const char* name, std::size_t size) {
+	if (!passed) {
+		std::printf("FAILED: %s, %zu digits\n", name, size);
+		failures++;
+	}
+}
+
+/* root^k + remainder == value with 0 <= remainder < (root + 1)^k - root^k, which makes root the floor of the k-th root */
+bool is_floor_root(const calc::integer& value, std::uint64_t k, const calc::integer& root, const calc::integer& remainder) {
+	if (root.negative || remainder.negative)
+		return false;
+
+	if (!equal(calc::add(calc::power(root, k), remainder), value))
+		return false;
+
+	calc::integer next{ calc::add(root, calc::from_uint64(1, value.rad)) };
+
+	return calc::detail::compare(calc::add(calc::power(root, k), remainder).magnitude, calc::power(next, k).magnitude) < 0;
+}
+
+/* perfect powers, their neighbours and arbitrary values across sizes which take the word, search and Newton paths */
+void floor_roots(calc::number_base* base) {
+	std::uint64_t seed{ 7 };
+	calc::integer one{ calc::from_uint64(1, calc::make_radix(std::strlen(base->symbol_vec))) };
+
+	for (std::uint64_t k : { 2, 3, 5, 7, 16 }) {
+		for (std::size_t size : { 1, 3, 10, 20, 45, 150, 600 }) {
+			calc::integer base_root{ digits(size, seed, base) };
+			calc::integer exact{ calc::power(base_root, k) };
+			calc::integer root{};
+			calc::integer remainder{};
+
+			calc::rootrem(exact, k, root, remainder);
+			check(equal(root, base_root) && remainder.is_zero(), "a perfect power", size);
+
+			calc::rootrem(calc::subtract(exact, one), k, root, remainder);
+			check(equal(root, calc::subtract(base_root, one)) && is_floor_root(calc::subtract(exact, one), k, root, remainder), "one below a perfect power", size);
+
+			calc::rootrem(calc::add(exact, one), k, root, remainder);
+			check(equal(root, base_root) && equal(remainder, one), "one above a perfect power", size);
+
+			calc::integer value{ digits(size * k, seed, base) };
+			calc::rootrem(value, k, root, remainder);
+			check(is_floor_root(value, k, root, remainder), "an arbitrary value", size);
+		}
+	}
+}
+
+void small_values() {
+	calc::radix rad{ calc::make_radix(10) };
+
+	for (std::uint64_t k : { 1, 2, 3, 64, 1000 }) {
+		check(calc::iroot(calc::from_uint64(0, rad), k).is_zero(), "the root of zero", 1);
+		check(calc::to_uint64(calc::iroot(calc::from_uint64(1, rad), k)) == 1, "the root of one", 1);
+	}
+
+	check(calc::to_uint64(calc::iroot(calc::from_uint64(12345, rad), 1)) == 12345, "the first root", 5);
+	check(calc::to_uint64(calc::isqrt(calc::from_uint64(99, rad))) == 9, "isqrt(99)", 2);
+	check(calc::to_uint64(calc::isqrt(calc::from_uint64(100, rad))) == 10, "isqrt(100)", 3);
+	check(calc::to_uint64(calc::isqrt(calc::from_uint64(~std::uint64_t{}, rad))) == 4294967295, "isqrt(2^64 - 1)", 20);
+	check(calc::to_uint64(calc::iroot(calc::from_uint64(~std::uint64_t{}, rad), 63)) == 2, "the 63rd root of 2^64 - 1", 20);
+}
+
+/* odd roots of negative values are negative with a negative remainder, even roots and the zeroth root throw */
+void signs() {
+	calc::radix rad{ calc::make_radix(10) };
+	calc::integer value{ calc::from_uint64(30, rad) };
+	value.negative = true;
+
+	calc::integer root{};
+	calc::integer remainder{};
+
+	calc::rootrem(value, 3, root, remainder);
+	check(root.negative && calc::to_uint64(root) == 3 && remainder.negative && calc::to_uint64(remainder) == 3, "the cube root of -30", 2);
+
+	bool thrown{};
+
+	try {
+		calc::isqrt(value);
+	}
+	catch (const std::domain_error&) {
+		thrown = true;
+	}
+
+	check(thrown, "the square root of a negative value throws", 2);
+
+	thrown = false;
+
+	try {
+		calc::iroot(calc::from_uint64(30, rad), 0);
+	}
+	catch (const std::domain_error&) {
+		thrown = true;
+	}
+
+	check(thrown, "the zeroth root throws", 2);
+}
+
+/* a degree at or above the bit length of the value gives 1 at once, instead of raising candidates to an enormous power */
+void huge_degrees() {
+	std::uint64_t seed{ 11 };
+	calc::integer value{ digits(2000, seed) };
+
+	auto start{ std::chrono::steady_clock::now() };
+
+	for (std::uint64_t k : { std::uint64_t{ 6644 }, std::uint64_t{ 100000 }, std::uint64_t{ 1 } << 40, ~std::uint64_t{} }) {
+		calc::integer root{};
+		calc::integer remainder{};
+
+		calc::rootrem(value, k, root, remainder);
+		check(calc::to_uint64(root) == 1 && equal(remainder, calc::subtract(value, calc::from_uint64(1, value.rad))), "a huge degree", 2000);
+	}
+
+	check(std::chrono::steady_clock::now() - start < std::chrono::seconds{ 5 }, "a huge degree is quick", 2000);
+
+	calc::integer root{};
+	calc::integer remainder{};
+
+	calc::rootrem(value, 6643, root, remainder);
+	check(is_floor_root(value, 6643, root, remainder), "a degree just below the bit length", 2000);
+}
+
+int main() {
+	floor_roots(&base10);
+	floor_roots(&base2);
+	floor_roots(&base16);
+	small_values();
+	signs();
+	huge_degrees();
+
+	if (failures == 0)
+		std::printf("all root cases passed\n");
+
+	return failures != 0;
+}